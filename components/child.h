@@ -11,10 +11,12 @@ class Child {
 public:
 	// The parent `Entity`.
 	EntityID parent;
-	// First child of next level.
-	EntityID first_child;
-	// The next child in this level
-	EntityID next;
+	// The position of this `Entity` into the children of its parent.
+	uint32_t child_index = UINT32_MAX;
+	// The children range into the `Hierarchy` children pool.
+	uint32_t children_offset = 0;
+	uint32_t children_count = 0;
+	uint32_t children_capacity = 0;
 
 	Child(EntityID p_parent);
 };
@@ -32,6 +32,10 @@ public:
 	ECSCLASS(m_class)                                                  \
 	friend class World;                                                \
                                                                        \
+public:                                                                \
+	/* Lets the `Query` call the storage without virtual calls. */     \
+	using StorageClass = m_storage_class<m_class>;                     \
+                                                                       \
 private:                                                               \
 	/* Storages */                                                     \
 	static _FORCE_INLINE_ m_storage_class<m_class> *create_storage() { \
@@ -49,6 +53,12 @@ private:                                                               \
 	m_class() = default;                                   \
 	m_class(const m_class &) = default;
 
+/// Register a tag component: a marker without data, stored by the
+/// `TagStorage` (include `storage/tag_storage.h`).
+#define COMPONENT_TAG(m_class)          \
+	COMPONENT(m_class, TagStorage)      \
+	static constexpr bool IS_TAG = true;
+
 /// Register a component using custom create storage function. The function is
 /// specified on `ECS::register_component<Component>([]() -> StorageBase * { /* Create the storage and return it. */ });`.
 #define COMPONENT_CUSTOM_STORAGE(m_class) \
@@ -64,6 +74,10 @@ private:                                  \
 	ECSCLASS(m_class)                                                                         \
 	friend class World;                                                                       \
                                                                                               \
+public:                                                                                       \
+	/* Lets the `Query` call the storage without virtual calls. */                            \
+	using StorageClass = BatchStorage<m_storage_class, m_batch, m_class>;                     \
+                                                                                              \
 private:                                                                                      \
 	/* Storages */                                                                            \
 	static _FORCE_INLINE_ BatchStorage<m_storage_class, m_batch, m_class> *create_storage() { \
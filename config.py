@@ -2,8 +2,17 @@ def can_build(env, platform):
     return True
 
 
+def get_opts(platform):
+    from SCons.Variables import BoolVariable
+
+    return [
+        BoolVariable("godex_benchmarks", "Compile the Godex benchmarks, executed with the tests", False),
+    ]
+
+
 def configure(env):
-    pass
+    if env["godex_benchmarks"]:
+        env.Append(CPPDEFINES=["GODEX_BENCHMARKS"])
 
 
 def has_custom_iterator():
@@ -3,6 +3,7 @@
 
 #include "components/dynamic_component.h"
 #include "core/object/message_queue.h"
+#include "core/os/os.h"
 #include "modules/godot/nodes/ecs_world.h"
 #include "pipeline/pipeline.h"
 #include "scene/main/scene_tree.h"
@@ -31,6 +32,10 @@ void ECS::_bind_methods() {
 	ClassDB::bind_method(D_METHOD("get_system_id", "name"), &ECS::get_system_id_obj);
 	ClassDB::bind_method(D_METHOD("verify_system_id", "name"), &ECS::verify_system_id_obj);
 
+	ClassDB::bind_method(D_METHOD("set_profiler_enabled", "enabled"), &ECS::set_profiler_enabled);
+	ClassDB::bind_method(D_METHOD("is_profiler_enabled"), &ECS::is_profiler_enabled);
+	ClassDB::bind_method(D_METHOD("get_profiler_chrome_trace"), &ECS::get_profiler_chrome_trace);
+
 	BIND_CONSTANT(NOTIFICATION_ECS_WORLD_LOADED)
 	BIND_CONSTANT(NOTIFICATION_ECS_WORLD_PRE_UNLOAD)
 	BIND_CONSTANT(NOTIFICATION_ECS_WORLD_UNLOADED)
@@ -100,6 +105,11 @@ bool ECS::storage_notify_release_write(godex::component_id p_component_id) {
 	return components_info[p_component_id].notify_release_write;
 }
 
+bool ECS::storage_is_structure_shared(godex::component_id p_component_id) {
+	ERR_FAIL_COND_V_MSG(verify_component_id(p_component_id) == false, false, "The component " + itos(p_component_id) + " is invalid.");
+	return components_info[p_component_id].structure_shared;
+}
+
 const LocalVector<PropertyInfo> *ECS::get_component_properties(uint32_t p_component_id) {
 	ERR_FAIL_COND_V_MSG(verify_component_id(p_component_id) == false, nullptr, "The `component_id` is invalid: " + itos(p_component_id));
 	if (components_info[p_component_id].dynamic_component_info != nullptr) {
@@ -459,6 +469,33 @@ bool ECS::has_active_world_pipeline() const {
 	return active_world_pipeline != nullptr;
 }
 
+void ECS::set_profiler_enabled(bool p_enabled) {
+	ERR_FAIL_COND_MSG(active_world == nullptr, "There is no active world to profile.");
+	if (p_enabled) {
+		active_world->create_databag<PipelineProfiler>().set_enabled(true);
+	} else {
+		PipelineProfiler *profiler = active_world->get_databag<PipelineProfiler>();
+		if (profiler) {
+			profiler->set_enabled(false);
+		}
+	}
+}
+
+bool ECS::is_profiler_enabled() const {
+	if (active_world == nullptr) {
+		return false;
+	}
+	const PipelineProfiler *profiler = active_world->get_databag<PipelineProfiler>();
+	return profiler != nullptr && profiler->is_enabled();
+}
+
+String ECS::get_profiler_chrome_trace() const {
+	ERR_FAIL_COND_V_MSG(active_world == nullptr, String(), "There is no active world.");
+	const PipelineProfiler *profiler = active_world->get_databag<PipelineProfiler>();
+	ERR_FAIL_COND_V_MSG(profiler == nullptr, String(), "The profiler was never enabled on the active world.");
+	return profiler->get_chrome_trace();
+}
+
 void ECS::dispatch_active_world() {
 	if (likely(active_world && active_world_pipeline)) {
 		if (unlikely(ready == false)) {
@@ -469,7 +506,15 @@ void ECS::dispatch_active_world() {
 
 		dispatching = true;
 		active_world_pipeline->dispatch(active_world);
-		active_world->flush();
+
+		PipelineProfiler *profiler = active_world->get_databag<PipelineProfiler>();
+		if (unlikely(profiler != nullptr && profiler->is_enabled())) {
+			const uint64_t flush_begin = OS::get_singleton()->get_ticks_usec();
+			active_world->flush();
+			profiler->set_flush_time(OS::get_singleton()->get_ticks_usec() - flush_begin);
+		} else {
+			active_world->flush();
+		}
 		dispatching = false;
 	}
 }
@@ -531,6 +576,7 @@ uint32_t ECS::register_script_component(const StringName &p_name, const LocalVec
 					false,
 					false,
 					false, // is_shared_component_storage?
+					false, // structure_shared?
 					DataAccessorFuncs() });
 
 	// Add a new scripting constant, for fast and easy `component` access.
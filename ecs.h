@@ -37,6 +37,7 @@ struct ComponentInfo {
 	bool notify_release_write = false;
 	bool is_event = false;
 	bool is_shareable = false;
+	bool structure_shared = false;
 
 	DataAccessorFuncs accessor_funcs;
 };
@@ -125,6 +126,7 @@ public:
 	static bool is_component_events(godex::component_id p_component_id);
 	static bool is_component_sharable(godex::component_id p_component_id);
 	static bool storage_notify_release_write(godex::component_id p_component_id);
+	static bool storage_is_structure_shared(godex::component_id p_component_id);
 
 	static const LocalVector<PropertyInfo> *get_component_properties(godex::component_id p_component_id);
 	static Variant get_component_property_default(godex::component_id p_component_id, StringName p_property_name);
@@ -241,6 +243,15 @@ public:
 
 	bool has_active_world_pipeline() const;
 
+	/// Enables the `PipelineProfiler` of the active world: the execution time
+	/// of each `System` is recorded.
+	void set_profiler_enabled(bool p_enabled);
+	bool is_profiler_enabled() const;
+
+	/// Returns the profiled frames of the active world, using the Chrome trace
+	/// event format (JSON).
+	String get_profiler_chrome_trace() const;
+
 	godex::component_id get_component_id_obj(StringName p_component_name) const {
 		return get_component_id(p_component_name);
 	}
@@ -280,6 +291,7 @@ void ECS::register_component(StorageBase *(*create_storage)()) {
 	bool notify_release_write = false;
 	bool shared_component_storage = false;
 	bool steady = false;
+	bool structure_shared = false;
 	{
 		// This storage wants to be notified once the write object is released?
 		StorageBase *s = create_storage();
@@ -291,6 +303,7 @@ void ECS::register_component(StorageBase *(*create_storage)()) {
 		}
 
 		steady = s->is_steady();
+		structure_shared = s->is_structure_shared();
 
 		delete s;
 	}
@@ -334,6 +347,7 @@ void ECS::register_component(StorageBase *(*create_storage)()) {
 					notify_release_write,
 					false,
 					shared_component_storage,
+					structure_shared,
 					DataAccessorFuncs{
 							C::get_properties,
 							C::get_property_default,
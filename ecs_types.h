@@ -45,35 +45,67 @@ enum class StorageType {
 	BATCH_DENSE_VECTOR,
 };
 
+/// Identifies an `Entity`.
+///
+/// The lower `INDEX_BITS` bits are the `Entity` index, the upper bits are the
+/// generation: each time an `Entity` is destroyed its index is recycled with
+/// the next generation, so an `EntityID` pointing to a destroyed `Entity` can
+/// be detected using `World::is_entity_alive()`.
+///
+/// The `EntityID` converts to its index, that is used by the storages to
+/// address the components.
 class EntityID {
 	uint32_t id = UINT32_MAX;
 
 public:
+	static constexpr uint32_t INDEX_BITS = 24;
+	static constexpr uint32_t INDEX_MASK = (1 << INDEX_BITS) - 1;
+	/// The index `INDEX_MASK` is reserved to the null `EntityID`.
+	static constexpr uint32_t MAX_INDEX = INDEX_MASK - 1;
+
 	EntityID() :
 			id(UINT32_MAX) {}
 
 	EntityID(const EntityID &) = default;
 
-	EntityID(uint32_t p_index) :
-			id(p_index) {}
+	/// Creates the `EntityID` from its raw id: index and generation.
+	EntityID(uint32_t p_id) :
+			id(p_id) {}
+
+	EntityID(uint32_t p_index, uint8_t p_generation) :
+			id((p_index & INDEX_MASK) | (uint32_t(p_generation) << INDEX_BITS)) {}
 
-	EntityID(Variant p_index) :
-			id(p_index.operator unsigned int()) {}
+	EntityID(Variant p_id) :
+			id(p_id.operator unsigned int()) {}
 
 	bool is_null() const {
 		return id == UINT32_MAX;
 	}
 
+	_FORCE_INLINE_ uint32_t get_index() const {
+		return id & INDEX_MASK;
+	}
+
+	_FORCE_INLINE_ uint8_t get_generation() const {
+		return id >> INDEX_BITS;
+	}
+
+	/// Returns the index and the generation packed together: use it to expose
+	/// the `EntityID` to the scripts.
+	_FORCE_INLINE_ uint32_t get_raw_id() const {
+		return id;
+	}
+
 	bool operator==(const EntityID &p_other) const {
 		return id == p_other.id;
 	}
 
-	bool operator==(uint32_t p_naked_index) const {
-		return id == p_naked_index;
+	bool operator==(uint32_t p_raw_id) const {
+		return id == p_raw_id;
 	}
 
 	operator uint32_t() const {
-		return id;
+		return id & INDEX_MASK;
 	}
 
 	operator Variant() const {
@@ -0,0 +1,148 @@
+#pragma once
+
+#include "query.h"
+#include "query_cache.h"
+
+/// `true` when the `Query` element is the `Changed` filter or nests it (like
+/// `Maybe<Changed<C>>` or `Any<Changed<A>, B>`).
+template <class C>
+struct has_changed_filter : std::false_type {};
+
+template <class C>
+struct has_changed_filter<Changed<C>> : std::true_type {};
+
+template <template <class...> class F, class... C>
+struct has_changed_filter<F<C...>> : std::bool_constant<(has_changed_filter<C>::value || ...)> {};
+
+/// `Query` that keeps the matching `Entities` across the dispatches, instead
+/// to check all the candidates each time it's created: the matches are
+/// updated with the `Entities` inserted into or removed from its storages,
+/// so iterating it is a walk over the precomputed matches.
+///
+/// It's convenient for the `System`s that iterate a small subset of big
+/// storages (like `Query<A, Not<B>>`), when the structural changes are rare
+/// compared to the iterations:
+/// ```
+/// void move_system(CachedQuery<TransformComponent, const Velocity> &p_query) {
+/// 	for (auto [transform, velocity] : p_query) {
+/// 		// ...
+/// 	}
+/// }
+/// ```
+///
+/// The matches are not sorted. The `Changed` filter is not supported, since
+/// it's not a structural change: use the `Query` for it.
+template <class... Cs>
+class CachedQuery {
+	static_assert((has_changed_filter<Cs>::value || ...) == false, "The `CachedQuery` can't use the `Changed` filter, since it's not a structural change: use the `Query`.");
+
+	/// Fetch space.
+	Space m_space = LOCAL;
+
+	World *world = nullptr;
+	QueryCache *cache = nullptr;
+
+	// Storages
+	QueryStorage<0, Cs...> q;
+
+public:
+	CachedQuery(World *p_world) :
+			world(p_world),
+			q(p_world) {
+		cache = p_world->get_query_cache(get_cache_id());
+
+		// Many `System`s may take the same `CachedQuery` at the same time:
+		// only the first of the stage updates it, then they all iterate it.
+		MutexLock lock(cache->get_mutex());
+		if (cache->is_set_up() == false) {
+			SystemExeInfo info;
+			get_components(info);
+			cache->setup(info);
+		}
+		const uint64_t stage = p_world->get_dispatch_stage();
+		if (cache->needs_update(stage)) {
+			cache->update(
+					p_world,
+					[&]() { return q.get_entities(); },
+					[&](EntityID p_entity) { return q.filter_satisfied(p_entity); });
+			cache->set_updated_stage(stage);
+		}
+		PipelineProfiler::count_entities(cache->get_matches().size());
+	}
+
+	struct Iterator {
+		using iterator_category = std::forward_iterator_tag;
+		using difference_type = std::ptrdiff_t;
+		using value_type = QueryResultTuple<Cs...>;
+
+		Iterator(CachedQuery<Cs...> *p_query, const EntityID *p_entity) :
+				query(p_query), entity(p_entity) {}
+
+		value_type operator*() const {
+			QueryResultTuple<Cs...> result;
+			query->q.fetch(*entity, query->m_space, result);
+			return result;
+		}
+
+		Iterator &operator++() {
+			entity += 1;
+			return *this;
+		}
+
+		Iterator operator++(int) {
+			Iterator tmp = *this;
+			++(*this);
+			return tmp;
+		}
+
+		friend bool operator==(const Iterator &a, const Iterator &b) { return a.entity == b.entity; }
+		friend bool operator!=(const Iterator &a, const Iterator &b) { return a.entity != b.entity; }
+
+	private:
+		CachedQuery<Cs...> *query;
+		const EntityID *entity;
+	};
+
+	/// Allow to specify the space you want to fetch the data, see `Query::space`.
+	CachedQuery<Cs...> &space(Space p_space) {
+		m_space = p_space;
+		return *this;
+	}
+
+	Iterator begin() {
+		return Iterator(this, cache->get_matches().ptr());
+	}
+
+	Iterator end() {
+		return Iterator(this, cache->get_matches().ptr() + cache->get_matches().size());
+	}
+
+	/// Returns true if this `Entity` exists and can be fetched.
+	bool has(EntityID p_entity) const {
+		return q.filter_satisfied(p_entity);
+	}
+
+	/// Fetch the specific `Entity` component, use `has` to check if the
+	/// `Entity` can be fetched.
+	QueryResultTuple<Cs...> operator[](EntityID p_entity) {
+		QueryResultTuple<Cs...> result;
+		q.fetch(p_entity, m_space, result);
+		return result;
+	}
+
+	/// Returns the amount of `Entities` that meet the requirements of this
+	/// `Query`, without iterating them.
+	uint32_t count() const {
+		return cache->get_matches().size();
+	}
+
+	static void get_components(SystemExeInfo &r_info) {
+		QueryStorage<0, Cs...>::get_components(r_info);
+	}
+
+private:
+	static uint32_t get_cache_id() {
+		static const uint32_t id = QueryCache::register_cache_id();
+		return id;
+	}
+};
@@ -2,6 +2,7 @@
 
 #include "../ecs.h"
 #include "../modules/godot/nodes/ecs_world.h"
+#include "../pipeline/pipeline_profiler.h"
 
 using godex::DynamicQuery;
 
@@ -160,7 +161,8 @@ void DynamicQuery::begin(World *p_world) {
 					// Not determinant, nothing to do.
 				} break;
 				case CHANGED_MODE: {
-					eb = storages[i]->get_changed_entities();
+					// The change ticks are checked by `has`.
+					eb = storages[i]->get_stored_entities();
 				} break;
 			}
 			if (eb.count < entities.count) {
@@ -175,6 +177,8 @@ void DynamicQuery::begin(World *p_world) {
 		ERR_PRINT("The Query can't be used if there are only non determinant filters (like `Without` and `Maybe`).");
 	}
 
+	PipelineProfiler::count_entities(entities.count);
+
 	if (entities.count > 0) {
 		if (has(entities.entities[0])) {
 			fetch(entities.entities[0]);
@@ -289,7 +293,7 @@ void DynamicQuery::fetch(EntityID p_entity_id) {
 }
 
 uint32_t DynamicQuery::script_get_current_entity_id() const {
-	return get_current_entity_id();
+	return get_current_entity_id().get_raw_id();
 }
 
 EntityID DynamicQuery::get_current_entity_id() const {
@@ -1,8 +1,16 @@
 #pragma once
 
+#include "../pipeline/pipeline_profiler.h"
+#include "../pipeline/thread_pool.h"
+#include "../storage/archetype_storage.h"
+#include "../storage/soa_storage.h"
 #include "../storage/storage.h"
+#include "../storage/storage_group.h"
+#include "../storage/tag_storage.h"
 #include "../systems/system.h"
 #include "../world/world.h"
+#include <tuple>
+#include <typeinfo>
 
 // ---------------------------------------------------------------- Query filters
 
@@ -478,6 +486,11 @@ constexpr fetch_element_type<S, 0, Cs...> get(const QueryResultTuple<Cs...> &tup
 
 // --------------------------------------------------------------- Query Storages
 
+/// `true` when the component is stored into a `SoAStorage`, that doesn't store
+/// it as `C`: so it can't be fetched.
+template <class C>
+inline constexpr bool is_soa_component_v = is_soa_storage<typename component_storage_class<std::remove_const_t<C>>::type>::value;
+
 /// `QueryStorage` specialization with 0 template arguments.
 template <std::size_t I, class... Cs>
 struct QueryStorage {
@@ -487,6 +500,12 @@ struct QueryStorage {
 		// False by default.
 		return false;
 	}
+
+	/// Returns `true` if this storage can be fetched concurrently by many
+	/// threads.
+	bool can_fetch_concurrently() const {
+		return true;
+	}
 	EntitiesBuffer get_entities() const {
 		// This is a NON determinant filter, so just return UINT32_MAX.
 		return { UINT32_MAX, nullptr };
@@ -511,6 +530,10 @@ struct QueryStorage<I, EntityID, Cs...> : public QueryStorage<I + 1, Cs...> {
 	QueryStorage(World *p_world) :
 			QueryStorage<I + 1, Cs...>(p_world) {}
 
+	bool can_fetch_concurrently() const {
+		return QueryStorage<I + 1, Cs...>::can_fetch_concurrently();
+	}
+
 	EntitiesBuffer get_entities() const {
 		return QueryStorage<I + 1, Cs...>::get_entities();
 	}
@@ -548,6 +571,10 @@ struct QueryStorage<I, Maybe<C>, Cs...> : public QueryStorage<I + 1, Cs...> {
 			query_storage(p_world) {
 	}
 
+	bool can_fetch_concurrently() const {
+		return query_storage.can_fetch_concurrently() && QueryStorage<I + 1, Cs...>::can_fetch_concurrently();
+	}
+
 	EntitiesBuffer get_entities() const {
 		// This is a NON determinant filter, so just return the other filter.
 		return QueryStorage<I + 1, Cs...>::get_entities();
@@ -595,6 +622,10 @@ struct QueryStorage<I, Not<C>, Cs...> : public QueryStorage<I + 1, Cs...> {
 			query_storage(p_world) {
 	}
 
+	bool can_fetch_concurrently() const {
+		return query_storage.can_fetch_concurrently() && QueryStorage<I + 1, Cs...>::can_fetch_concurrently();
+	}
+
 	EntitiesBuffer get_entities() const {
 		// This is a NON determinant filter, so just return the other filter.
 		return QueryStorage<I + 1, Cs...>::get_entities();
@@ -651,14 +682,23 @@ struct QueryStorage<I, Changed<C>, Cs...> : public QueryStorage<I + 1, Cs...> {
 		return true;
 	}
 
+	bool can_fetch_concurrently() const {
+		if constexpr (std::is_const<C>::value == false) {
+			if (storage != nullptr && storage->can_get_concurrently() == false) {
+				return false;
+			}
+		}
+		return QueryStorage<I + 1, Cs...>::can_fetch_concurrently();
+	}
+
 	EntitiesBuffer get_entities() const {
-		// This is a determinant filter, that iterates over the changed
-		// components of this storage.
+		// This is a determinant filter: it iterates over the components of
+		// this storage, and `filter_satisfied` compares their change tick.
 		const EntitiesBuffer o_entities = QueryStorage<I + 1, Cs...>::get_entities();
 		if (unlikely(storage == nullptr)) {
 			return o_entities;
 		}
-		const EntitiesBuffer entities = storage->get_changed_entities();
+		const EntitiesBuffer entities = storage->get_stored_entities();
 		return entities.count < o_entities.count ? entities : o_entities;
 	}
 
@@ -682,6 +722,7 @@ struct QueryStorage<I, Changed<C>, Cs...> : public QueryStorage<I + 1, Cs...> {
 		CRASH_COND_MSG(storage == nullptr, "The storage" + String(typeid(Storage<C>).name()) + " is null.");
 #endif
 
+		static_assert(is_soa_component_v<C> == false, "The `SoAStorage` components can't be fetched by the `Query`: take the `SoAStorage` as `System` argument.");
 		if constexpr (std::is_const<C>::value) {
 			set<I>(r_result, const_cast<const Storage<C> *>(storage)->get(p_id, p_mode));
 		} else {
@@ -721,6 +762,10 @@ struct QueryStorage<I, Batch<C>, Cs...> : public QueryStorage<I + 1, Cs...> {
 			query_storage(p_world) {
 	}
 
+	bool can_fetch_concurrently() const {
+		return query_storage.can_fetch_concurrently() && QueryStorage<I + 1, Cs...>::can_fetch_concurrently();
+	}
+
 	EntitiesBuffer get_entities() const {
 		return query_storage.get_entities();
 	}
@@ -798,6 +843,11 @@ struct AJUtility {
 		return false;
 	}
 
+	/// At this point, all the sub storages can be fetched concurrently.
+	bool can_fetch_concurrently() const {
+		return true;
+	}
+
 	void get_entities(EntityList &r_entities) const {}
 
 	bool filter_satisfied(EntityID p_entity) const {
@@ -845,6 +895,11 @@ struct AJUtility<I, INCREMENT, C, Cs...> : AJUtility<I + INCREMENT, INCREMENT, C
 		}
 	}
 
+	/// Return `true` when all the sub storages can be fetched concurrently.
+	bool can_fetch_concurrently() const {
+		return storage.can_fetch_concurrently() && AJUtility<I + INCREMENT, INCREMENT, Cs...>::can_fetch_concurrently();
+	}
+
 	void get_entities(EntityList &r_entities) const {
 		if (storage.get_entities().count != UINT32_MAX) {
 			// This is a determinant fitler, take the `Entities`.
@@ -936,6 +991,10 @@ struct QueryStorage<I, Any<C...>, Cs...> : QueryStorage<AJUtility<I, 1, C...>::L
 		return AJUtility<I, 1, C...>::any_determinant();
 	}
 
+	bool can_fetch_concurrently() const {
+		return sub_storages.can_fetch_concurrently() && QueryStorage<AJUtility<I, 1, C...>::LAST_INDEX, Cs...>::can_fetch_concurrently();
+	}
+
 	EntitiesBuffer get_entities() const {
 		if constexpr (is_filter_derminant()) {
 			return EntitiesBuffer(entities.size(), entities.get_entities_ptr());
@@ -1012,6 +1071,10 @@ struct QueryStorage<I, Join<C...>, Cs...> : QueryStorage<I + 1, Cs...> {
 		return AJUtility<0, 0, C...>::any_determinant();
 	}
 
+	bool can_fetch_concurrently() const {
+		return sub_storages.can_fetch_concurrently() && QueryStorage<I + 1, Cs...>::can_fetch_concurrently();
+	}
+
 	EntitiesBuffer get_entities() const {
 		if constexpr (is_filter_derminant()) {
 			return EntitiesBuffer(entities.size(), entities.get_entities_ptr());
@@ -1063,11 +1126,24 @@ struct QueryStorage<I, Join<C...>, Cs...> : QueryStorage<I + 1, Cs...> {
 /// `QueryStorage` no filter specialization.
 template <std::size_t I, class C, class... Cs>
 struct QueryStorage<I, C, Cs...> : QueryStorage<I + 1, Cs...> {
+	using StorageClass = typename component_storage_class<std::remove_const_t<C>>::type;
+
 	Storage<C> *storage = nullptr;
+	/// The storage as its concrete type, set when it's known at compile time
+	/// and the storage is exactly of that type: `has` and `get` are called
+	/// without the virtual dispatch, so they inline into the iteration.
+	StorageClass *concrete_storage = nullptr;
 
 	QueryStorage(World *p_world) :
 			QueryStorage<I + 1, Cs...>(p_world),
 			storage(p_world->get_storage<C>()) {
+		if constexpr (std::is_void<StorageClass>::value == false) {
+			// The storage may be replaced by a custom one, at registration.
+			StorageBase *base = static_cast<StorageBase *>(storage);
+			if (base != nullptr && typeid(*base) == typeid(StorageClass)) {
+				concrete_storage = static_cast<StorageClass *>(base);
+			}
+		}
 	}
 
 	constexpr static bool is_filter_derminant() {
@@ -1075,6 +1151,15 @@ struct QueryStorage<I, C, Cs...> : QueryStorage<I + 1, Cs...> {
 		return true;
 	}
 
+	bool can_fetch_concurrently() const {
+		if constexpr (std::is_const<C>::value == false) {
+			if (storage != nullptr && storage->can_get_concurrently() == false) {
+				return false;
+			}
+		}
+		return QueryStorage<I + 1, Cs...>::can_fetch_concurrently();
+	}
+
 	EntitiesBuffer get_entities() const {
 		// This is a determinant filter, that iterates over the existing
 		// components of this storage.
@@ -1092,11 +1177,11 @@ struct QueryStorage<I, C, Cs...> : QueryStorage<I + 1, Cs...> {
 			// immediately.
 			return false;
 		}
-		return storage->has(p_entity) && QueryStorage<I + 1, Cs...>::filter_satisfied(p_entity);
+		return storage_has(p_entity) && QueryStorage<I + 1, Cs...>::filter_satisfied(p_entity);
 	}
 
 	bool can_fetch(EntityID p_entity) const {
-		return storage && storage->has(p_entity);
+		return storage && storage_has(p_entity);
 	}
 
 	template <class... Qs>
@@ -1106,8 +1191,25 @@ struct QueryStorage<I, C, Cs...> : QueryStorage<I + 1, Cs...> {
 		CRASH_COND_MSG(storage == nullptr, "The storage" + String(typeid(Storage<C>).name()) + " is null.");
 #endif
 
+		static_assert(is_soa_component_v<C> == false, "The `SoAStorage` components can't be fetched by the `Query`: take the `SoAStorage` as `System` argument.");
+
 		// Set the `Component` inside th tuple.
-		if constexpr (std::is_const<C>::value) {
+		if constexpr (is_tag_component<std::remove_const_t<C>>::value) {
+			// The tags have no data: all the `Entities` share the same instance.
+			set<I>(r_result, TagStorage<std::remove_const_t<C>>::get_tag());
+		} else if constexpr (std::is_void<StorageClass>::value == false && std::is_const<C>::value) {
+			if (likely(concrete_storage != nullptr)) {
+				set<I>(r_result, const_cast<const StorageClass *>(concrete_storage)->StorageClass::get(p_id, p_mode));
+			} else {
+				set<I>(r_result, const_cast<const Storage<C> *>(storage)->get(p_id, p_mode));
+			}
+		} else if constexpr (std::is_void<StorageClass>::value == false) {
+			if (likely(concrete_storage != nullptr)) {
+				set<I>(r_result, concrete_storage->StorageClass::get(p_id, p_mode));
+			} else {
+				set<I>(r_result, storage->get(p_id, p_mode));
+			}
+		} else if constexpr (std::is_const<C>::value) {
 			set<I>(r_result, const_cast<const Storage<C> *>(storage)->get(p_id, p_mode));
 		} else {
 			set<I>(r_result, storage->get(p_id, p_mode));
@@ -1121,6 +1223,23 @@ struct QueryStorage<I, C, Cs...> : QueryStorage<I + 1, Cs...> {
 		return storage;
 	}
 
+private:
+	bool storage_has(EntityID p_entity) const {
+		if constexpr (is_tag_component<std::remove_const_t<C>>::value) {
+			// Not virtual, just a bit check.
+			return static_cast<const TagStorage<std::remove_const_t<C>> *>(static_cast<const StorageBase *>(storage))->has_tag(p_entity);
+		} else if constexpr (std::is_void<StorageClass>::value == false) {
+			if (likely(concrete_storage != nullptr)) {
+				return concrete_storage->StorageClass::has(p_entity);
+			}
+			return storage->has(p_entity);
+		} else {
+			return storage->has(p_entity);
+		}
+	}
+
+public:
+
 	static void get_components(SystemExeInfo &r_info, const bool p_force_immutable = false) {
 		if (std::is_const<C>::value || p_force_immutable) {
 			r_info.immutable_components.insert(C::get_component_id());
@@ -1131,6 +1250,72 @@ struct QueryStorage<I, C, Cs...> : QueryStorage<I + 1, Cs...> {
 	}
 };
 
+// ------------------------------------------------------------------ Query Chunk
+
+/// The type of a `QueryChunk` span: a pointer to the first component, the
+/// `EntityID`s are read only.
+template <class C>
+struct chunk_element {
+	using type = C *;
+};
+
+template <>
+struct chunk_element<EntityID> {
+	using type = const EntityID *;
+};
+
+/// `true` when the `Query` element can be fetched by chunk: only the
+/// components and the `EntityID` can, the filters can't.
+template <class C>
+struct is_chunk_element : std::true_type {};
+
+template <class C>
+struct is_chunk_element<Not<C>> : std::false_type {};
+
+template <class C>
+struct is_chunk_element<Maybe<C>> : std::false_type {};
+
+template <class C>
+struct is_chunk_element<Changed<C>> : std::false_type {};
+
+template <class C>
+struct is_chunk_element<Batch<C>> : std::false_type {};
+
+template <class... C>
+struct is_chunk_element<Any<C...>> : std::false_type {};
+
+template <class... C>
+struct is_chunk_element<Join<C...>> : std::false_type {};
+
+/// Returns the component ID of a chunk element, `COMPONENT_NONE` for the
+/// `EntityID`.
+template <class C>
+godex::component_id chunk_element_component_id() {
+	if constexpr (std::is_same<C, EntityID>::value) {
+		return godex::COMPONENT_NONE;
+	} else {
+		return std::remove_const<C>::type::get_component_id();
+	}
+}
+
+/// A set of `count` entities returned by `Query::chunks()`. For each `Query`
+/// element, `spans` contains the pointer to the first component: the
+/// components of the chunk are stored contiguously, so you can just index it.
+/// ```
+/// Query<EntityID, TransformComponent, const Velocity> query(&world);
+/// for (auto chunk : query.chunks()) {
+/// 	auto [entities, transforms, velocities] = chunk.spans;
+/// 	for (uint32_t i = 0; i < chunk.count; i += 1) {
+/// 		transforms[i].transform.origin += velocities[i].velocity;
+/// 	}
+/// }
+/// ```
+template <class... Cs>
+struct QueryChunk {
+	uint32_t count = 0;
+	std::tuple<typename chunk_element<Cs>::type...> spans;
+};
+
 /// This is the fastest `Query`.
 /// Using the variadic template, it's build at compile time. Since the
 /// components must be known at compile time, this query can't by used by
@@ -1143,11 +1328,19 @@ class Query {
 	/// List of entities to check.
 	EntitiesBuffer entities = EntitiesBuffer(0, nullptr);
 
+	World *world = nullptr;
+
+	/// `true` when the components of this `Query` are exactly the ones of a
+	/// `StorageGroup`: `entities` is the group prefix, and all of them
+	/// satisfy the `Query`.
+	bool grouped = false;
+
 	// Storages
 	QueryStorage<0, Cs...> q;
 
 public:
 	Query(World *p_world) :
+			world(p_world),
 			q(p_world) {
 		// Prepare the query:
 		// Ask all the pointed storage to return a list of entities to iterate;
@@ -1157,6 +1350,10 @@ public:
 			entities.count = 0;
 			ERR_PRINT("This query is not valid, you are using only non determinant fileters (like `Not` and `Maybe`).");
 		}
+		if constexpr ((is_chunk_element<Cs>::value && ...)) {
+			fetch_group();
+		}
+		PipelineProfiler::count_entities(entities.count);
 	}
 
 	struct Iterator {
@@ -1222,7 +1419,7 @@ public:
 	/// ```
 	Iterator begin() {
 		// Returns the next available Entity.
-		if (entities.count > 0) {
+		if (entities.count > 0 && grouped == false) {
 			if (q.filter_satisfied(*entities.entities) == false) {
 				return Iterator(this, next_valid_entity(entities.entities));
 			}
@@ -1271,13 +1468,367 @@ public:
 		return count;
 	}
 
+	/// Executes `p_func` for each `Entity` that satisfies this `Query`, using
+	/// all the available threads.
+	/// The entities are split in ranges of `p_grain` entities, and each
+	/// worker keeps taking the next free range till all are processed.
+	/// ```
+	/// Query<const Velocity, const TransformComponent> query(world);
+	/// query.par_for_each([](QueryResultTuple<const Velocity, const TransformComponent> p_result) {
+	/// 	auto [velocity, transform] = p_result;
+	/// 	// ...
+	/// }, 1024);
+	/// ```
+	///
+	/// `p_func` is called concurrently, so it must not touch shared data
+	/// without synchronization. The components can be fetched mutably: the
+	/// changes are recorded by each worker and applied, in order, once the
+	/// iteration is done.
+	///
+	/// This is executed on the calling thread when:
+	/// - The thread pool is already in use (for example, the `System` is
+	///   running in parallel with other `System`s).
+	/// - A component is fetched mutably from a storage that doesn't support
+	///   concurrent access (like the shared storages, where many entities
+	///   point to the same component).
+	template <class F>
+	void par_for_each(F p_func, uint32_t p_grain = 1024) {
+		if (unlikely(p_grain == 0)) {
+			p_grain = 1;
+		}
+
+		const uint32_t ranges = (entities.count / p_grain) + (entities.count % p_grain == 0 ? 0 : 1);
+		if (ranges > 1 && q.can_fetch_concurrently()) {
+			LocalVector<LocalVector<RecordedChange>> changes;
+			changes.resize(ranges);
+			ParallelJob<F> job{ &p_func, p_grain, changes.ptr(), StorageBase::get_system_ticks() };
+			if (godex::ThreadPool::do_work(ranges, this, &Query::template par_for_each_range<F>, job)) {
+				for (uint32_t i = 0; i < ranges; i += 1) {
+					StorageBase::apply_recorded_changes(changes[i]);
+				}
+				return;
+			}
+		}
+
+		// Fallback to single thread.
+		for (Iterator it = begin(); it != end(); ++it) {
+			p_func(*it);
+		}
+	}
+
+	/// Iterates the `Query` by chunks, use it through `chunks()`.
+	class Chunks {
+		static constexpr uint32_t ELEMENTS = sizeof...(Cs);
+		static constexpr bool IS_ENTITY[ELEMENTS] = { std::is_same<Cs, EntityID>::value... };
+		static constexpr bool IS_CONST[ELEMENTS] = { std::is_const<Cs>::value... };
+
+		enum Mode {
+			/// Each chunk contains a single `Entity`.
+			MODE_ENTITY,
+			/// A single chunk, with all the components of a dense storage, or
+			/// the prefix of a `StorageGroup`.
+			MODE_DENSE,
+			/// A chunk per `Archetype` chunk.
+			MODE_ARCHETYPE,
+		};
+
+		struct ArchetypeChunks {
+			Archetype *archetype;
+			int32_t columns[ELEMENTS];
+		};
+
+		Query<Cs...> *query;
+		Mode mode = MODE_ENTITY;
+		/// The storage of each element, `nullptr` for the `EntityID`.
+		StorageBase *storages[ELEMENTS];
+		/// The dense array of each element, used by `MODE_DENSE`.
+		void *dense_data[ELEMENTS];
+		LocalVector<ArchetypeChunks> archetypes;
+
+	public:
+		struct Iterator {
+			Iterator(Chunks *p_chunks, uint32_t p_outer, uint32_t p_inner) :
+					chunks(p_chunks), outer(p_outer), inner(p_inner) {}
+
+			QueryChunk<Cs...> operator*() const {
+				return chunks->fetch(outer, inner);
+			}
+
+			Iterator &operator++() {
+				chunks->next(outer, inner);
+				return *this;
+			}
+
+			friend bool operator==(const Iterator &a, const Iterator &b) { return a.outer == b.outer && a.inner == b.inner; }
+			friend bool operator!=(const Iterator &a, const Iterator &b) { return a.outer != b.outer || a.inner != b.inner; }
+
+		private:
+			Chunks *chunks;
+			uint32_t outer;
+			uint32_t inner;
+		};
+
+		Chunks(Query<Cs...> *p_query) :
+				query(p_query) {
+			const godex::component_id ids[ELEMENTS] = { chunk_element_component_id<Cs>()... };
+
+			uint32_t components = 0;
+			uint32_t last_component = 0;
+			ArchetypeTable *table = nullptr;
+			bool same_table = true;
+			for (uint32_t k = 0; k < ELEMENTS; k += 1) {
+				if (IS_ENTITY[k]) {
+					storages[k] = nullptr;
+					continue;
+				}
+				storages[k] = query->world->get_storage(ids[k]);
+				components += 1;
+				last_component = k;
+
+				ArchetypeStorageBase *archetype_storage = dynamic_cast<ArchetypeStorageBase *>(storages[k]);
+				if (archetype_storage == nullptr || (table != nullptr && table != archetype_storage->get_table())) {
+					same_table = false;
+				} else {
+					table = archetype_storage->get_table();
+				}
+			}
+
+			if (query->m_space == GLOBAL) {
+				// The storages keep the local components contiguous: the
+				// global ones are fetched one `Entity` at a time.
+				mode = MODE_ENTITY;
+			} else if (components > 0 && same_table) {
+				// All the components are in the same `ArchetypeTable`: iterate
+				// the chunks of the archetypes that have all of them.
+				mode = MODE_ARCHETYPE;
+				for (uint32_t a = 0; a < table->get_archetype_count(); a += 1) {
+					ArchetypeChunks archetype_chunks;
+					archetype_chunks.archetype = table->get_archetype(a);
+					if (archetype_chunks.archetype->get_size() == 0) {
+						continue;
+					}
+					bool has_all = true;
+					for (uint32_t k = 0; k < ELEMENTS && has_all; k += 1) {
+						archetype_chunks.columns[k] = IS_ENTITY[k] ? -1 : archetype_chunks.archetype->get_column(ids[k]);
+						has_all = IS_ENTITY[k] || archetype_chunks.columns[k] != -1;
+					}
+					if (has_all) {
+						archetypes.push_back(archetype_chunks);
+					}
+				}
+			} else if (query->grouped) {
+				// The group keeps the components of its `Entities` at the same
+				// slots: the group prefix is just one chunk.
+				mode = MODE_DENSE;
+				for (uint32_t k = 0; k < ELEMENTS; k += 1) {
+					dense_data[k] = IS_ENTITY[k] ? nullptr : storages[k]->get_dense_data();
+				}
+			} else if (components == 1 && storages[last_component] != nullptr) {
+				// A single component: if its storage is dense, the whole storage
+				// is just one chunk.
+				dense_data[last_component] = storages[last_component]->get_dense_data();
+				if (dense_data[last_component] != nullptr) {
+					mode = MODE_DENSE;
+					for (uint32_t k = 0; k < ELEMENTS; k += 1) {
+						dense_data[k] = dense_data[last_component];
+					}
+				}
+			}
+		}
+
+		Iterator begin() {
+			switch (mode) {
+				case MODE_ARCHETYPE:
+					return Iterator(this, 0, 0);
+				case MODE_DENSE:
+					return Iterator(this, query->entities.count == 0 ? 1 : 0, 0);
+				case MODE_ENTITY:
+				default: {
+					uint32_t first = 0;
+					while (first < query->entities.count && query->q.filter_satisfied(query->entities.entities[first]) == false) {
+						first += 1;
+					}
+					return Iterator(this, 0, first);
+				}
+			}
+		}
+
+		Iterator end() {
+			switch (mode) {
+				case MODE_ARCHETYPE:
+					return Iterator(this, archetypes.size(), 0);
+				case MODE_DENSE:
+					return Iterator(this, 1, 0);
+				case MODE_ENTITY:
+				default:
+					return Iterator(this, 0, query->entities.count);
+			}
+		}
+
+	private:
+		template <class C>
+		static typename chunk_element<C>::type element_span(const EntityID *p_entities, void *p_data) {
+			if constexpr (std::is_same<C, EntityID>::value) {
+				return p_entities;
+			} else {
+				return static_cast<C *>(p_data);
+			}
+		}
+
+		template <std::size_t... Is>
+		static void set_spans(QueryChunk<Cs...> &r_chunk, const EntityID *p_entities, void *const *p_data, std::index_sequence<Is...>) {
+			((std::get<Is>(r_chunk.spans) = element_span<Cs>(p_entities, p_data[Is])), ...);
+		}
+
+		void next(uint32_t &r_outer, uint32_t &r_inner) const {
+			switch (mode) {
+				case MODE_ARCHETYPE: {
+					const Archetype *archetype = archetypes[r_outer].archetype;
+					r_inner += 1;
+					if (r_inner >= archetype->get_chunk_count() || archetype->get_chunk_size(r_inner) == 0) {
+						r_outer += 1;
+						r_inner = 0;
+					}
+				} break;
+				case MODE_DENSE:
+					r_outer = 1;
+					break;
+				case MODE_ENTITY:
+				default:
+					for (r_inner += 1; r_inner < query->entities.count; r_inner += 1) {
+						if (query->q.filter_satisfied(query->entities.entities[r_inner])) {
+							break;
+						}
+					}
+					break;
+			}
+		}
+
+		QueryChunk<Cs...> fetch(uint32_t p_outer, uint32_t p_inner) const {
+			QueryChunk<Cs...> chunk;
+			const EntityID *entities = nullptr;
+			void *data[ELEMENTS];
+
+			switch (mode) {
+				case MODE_ARCHETYPE: {
+					const ArchetypeChunks &archetype_chunks = archetypes[p_outer];
+					chunk.count = archetype_chunks.archetype->get_chunk_size(p_inner);
+					entities = archetype_chunks.archetype->get_chunk_entities(p_inner);
+					for (uint32_t k = 0; k < ELEMENTS; k += 1) {
+						data[k] = IS_ENTITY[k] ? nullptr : archetype_chunks.archetype->get_chunk_column(p_inner, archetype_chunks.columns[k]);
+					}
+				} break;
+				case MODE_DENSE: {
+					chunk.count = query->entities.count;
+					entities = query->entities.entities;
+					for (uint32_t k = 0; k < ELEMENTS; k += 1) {
+						data[k] = IS_ENTITY[k] ? nullptr : dense_data[k];
+					}
+				} break;
+				case MODE_ENTITY:
+				default: {
+					chunk.count = 1;
+					entities = query->entities.entities + p_inner;
+					for (uint32_t k = 0; k < ELEMENTS; k += 1) {
+						if (IS_ENTITY[k]) {
+							data[k] = nullptr;
+						} else if (IS_CONST[k]) {
+							data[k] = const_cast<void *>(const_cast<const StorageBase *>(storages[k])->get_ptr(*entities, query->m_space));
+						} else {
+							// Already notifies the change.
+							data[k] = storages[k]->get_ptr(*entities, query->m_space);
+						}
+					}
+					set_spans(chunk, entities, data, std::index_sequence_for<Cs...>());
+					return chunk;
+				}
+			}
+
+			// The memory is accessed directly, so notify the changes here.
+			for (uint32_t k = 0; k < ELEMENTS; k += 1) {
+				if (IS_ENTITY[k] == false && IS_CONST[k] == false && storages[k]->is_tracing_change()) {
+					for (uint32_t i = 0; i < chunk.count; i += 1) {
+						storages[k]->notify_changed(entities[i]);
+					}
+				}
+			}
+
+			set_spans(chunk, entities, data, std::index_sequence_for<Cs...>());
+			return chunk;
+		}
+	};
+
+	/// Returns the chunks of this `Query`, so you can write tight loops over
+	/// contiguous memory:
+	/// ```
+	/// Query<EntityID, Position, const Velocity> query(&world);
+	/// for (auto chunk : query.chunks()) {
+	/// 	auto [entities, positions, velocities] = chunk.spans;
+	/// 	for (uint32_t i = 0; i < chunk.count; i += 1) {
+	/// 		positions[i].x += velocities[i].x;
+	/// 	}
+	/// }
+	/// ```
+	///
+	/// The chunks are contiguous when:
+	/// - All the components are stored by `ArchetypeStorage`s: a chunk for
+	///   each archetype chunk that contains all of them.
+	/// - There is a single component, stored in a dense storage (like the
+	///   `DenseVectorStorage`): a single chunk with all the entities.
+	/// - The components are exactly the ones of a `StorageGroup`: a single
+	///   chunk with the `Entities` that have all of them.
+	///
+	/// Otherwise, or when the `Query` is in `GLOBAL` space, each chunk contains
+	/// a single `Entity`.
+	///
+	/// Only the components and the `EntityID` can be fetched by chunks, the
+	/// filters are not supported.
+	Chunks chunks() {
+		static_assert((is_chunk_element<Cs>::value && ...), "The `Query` filters (`Not`, `Maybe`, `Changed`, `Batch`, `Any`, `Join`) can't be fetched by chunks.");
+		return Chunks(this);
+	}
+
 	static void get_components(SystemExeInfo &r_info) {
 		QueryStorage<0, Cs...>::get_components(r_info);
 	}
 
 private:
+	template <class F>
+	struct ParallelJob {
+		F *func;
+		uint32_t grain;
+		LocalVector<RecordedChange> *changes;
+		/// The ticks of the calling `System`, so `Changed` works the same on
+		/// the worker threads.
+		SystemTicks ticks;
+	};
+
+	template <class F>
+	void par_for_each_range(uint32_t p_range, ParallelJob<F> p_job) {
+		const SystemTicks previous_ticks = StorageBase::set_system_ticks(p_job.ticks);
+		StorageBase::begin_recording_changes(p_job.changes + p_range);
+
+		const uint32_t from = p_range * p_job.grain;
+		const uint32_t to = MIN(from + p_job.grain, entities.count);
+		for (uint32_t i = from; i < to; i += 1) {
+			const EntityID entity = entities.entities[i];
+			if (grouped || q.filter_satisfied(entity)) {
+				QueryResultTuple<Cs...> result;
+				q.fetch(entity, m_space, result);
+				(*p_job.func)(result);
+			}
+		}
+
+		StorageBase::end_recording_changes();
+		StorageBase::set_system_ticks(previous_ticks);
+	}
+
 	const EntityID *next_valid_entity(const EntityID *p_current) {
 		const EntityID *next = p_current + 1;
+		if (grouped) {
+			// All the group `Entities` have the components.
+			return next;
+		}
 
 		// Search the next valid entity.
 		for (; next != (entities.entities + entities.count); next += 1) {
@@ -1290,4 +1841,29 @@ private:
 		// Nothing more to iterate.
 		return next;
 	}
+
+	/// When all the components of this `Query` are owned by the same
+	/// `StorageGroup`, and it has no other components, iterates its prefix.
+	void fetch_group() {
+		const godex::component_id ids[] = { chunk_element_component_id<Cs>()... };
+		godex::component_id components[sizeof...(Cs)];
+		uint32_t count = 0;
+		StorageGroup *group = nullptr;
+		for (uint32_t k = 0; k < sizeof...(Cs); k += 1) {
+			if (ids[k] == godex::COMPONENT_NONE) {
+				continue;
+			}
+			const GroupStorageBase *storage = dynamic_cast<const GroupStorageBase *>(world->get_storage(ids[k]));
+			if (storage == nullptr || storage->get_group() == nullptr || (group != nullptr && group != storage->get_group())) {
+				return;
+			}
+			group = storage->get_group();
+			components[count] = ids[k];
+			count += 1;
+		}
+		if (group != nullptr && group->has_exactly(components, count)) {
+			grouped = true;
+			entities = group->get_entities();
+		}
+	}
 };
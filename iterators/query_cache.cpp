@@ -0,0 +1,105 @@
+#include "query_cache.h"
+
+#include "../world/world.h"
+#include <atomic>
+
+uint32_t QueryCache::register_cache_id() {
+	static std::atomic<uint32_t> next_id{ 0 };
+	return next_id.fetch_add(1);
+}
+
+Mutex &QueryCache::get_mutex() {
+	return mutex;
+}
+
+bool QueryCache::is_set_up() const {
+	return is_setup;
+}
+
+void QueryCache::setup(const SystemExeInfo &p_info) {
+	components.clear();
+	for (const Set<uint32_t>::Element *e = p_info.mutable_components.front(); e; e = e->next()) {
+		components.push_back(e->get());
+	}
+	for (const Set<uint32_t>::Element *e = p_info.immutable_components.front(); e; e = e->next()) {
+		if (components.find(e->get()) < 0) {
+			components.push_back(e->get());
+		}
+	}
+	storages.resize(components.size());
+	cursors.resize(components.size());
+	for (uint32_t i = 0; i < components.size(); i += 1) {
+		storages[i] = nullptr;
+		cursors[i] = 0;
+	}
+	is_setup = true;
+	valid = false;
+}
+
+void QueryCache::invalidate() {
+	valid = false;
+	updated_stage = 0;
+}
+
+bool QueryCache::needs_update(uint64_t p_stage) const {
+	return p_stage == 0 || p_stage != updated_stage;
+}
+
+void QueryCache::set_updated_stage(uint64_t p_stage) {
+	updated_stage = p_stage;
+}
+
+const LocalVector<EntityID> &QueryCache::get_matches() const {
+	return matches;
+}
+
+bool QueryCache::fetch_storages(World *p_world) {
+	bool rebuild = valid == false;
+	for (uint32_t i = 0; i < components.size(); i += 1) {
+		StorageBase *storage = p_world->get_storage(components[i]);
+		if (storage != storages[i]) {
+			storages[i] = storage;
+			rebuild = true;
+		}
+		if (storage == nullptr) {
+			continue;
+		}
+		if (storage->notifies_entity_signature() == false || storage->is_structure_shared()) {
+			// Its changes can't be tracked.
+			rebuild = true;
+			continue;
+		}
+		storage->enable_structural_log();
+		if (cursors[i] < storage->get_structural_log_begin() || cursors[i] > storage->get_structural_log_end()) {
+			// Some entries were trimmed before this cache could read them.
+			rebuild = true;
+		}
+	}
+	valid = true;
+	return rebuild;
+}
+
+void QueryCache::add_match(EntityID p_entity) {
+	const uint32_t index = match_index.get(p_entity.get_index());
+	if (index == UINT32_MAX) {
+		match_index.set(p_entity.get_index(), matches.size());
+		matches.push_back(p_entity);
+	} else {
+		// The index may be reused by a new `Entity`.
+		matches[index] = p_entity;
+	}
+}
+
+void QueryCache::remove_match(EntityID p_entity) {
+	const uint32_t index = match_index.get(p_entity.get_index());
+	if (index == UINT32_MAX) {
+		return;
+	}
+	const uint32_t last = matches.size() - 1;
+	if (index != last) {
+		matches[index] = matches[last];
+		match_index.set(matches[index].get_index(), index);
+	}
+	matches.resize(last);
+	match_index.unset(p_entity.get_index());
+}
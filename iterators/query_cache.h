@@ -0,0 +1,109 @@
+#pragma once
+
+#include "../storage/paged_sparse_array.h"
+#include "../storage/storage.h"
+#include "../systems/system.h"
+#include "core/os/mutex.h"
+#include "core/templates/local_vector.h"
+
+class World;
+
+/// The `Entities` that satisfy a `CachedQuery`, kept by the `World` across
+/// the dispatches.
+///
+/// Instead to check all the candidates each time, the cache reads the
+/// structural log of its storages (the `Entities` inserted or removed since
+/// the last update) and re-checks just those. It's rebuilt from scratch when
+/// the log was trimmed before it could read it, when a storage is created or
+/// destroyed, or when a storage can't log its changes.
+class QueryCache {
+	Mutex mutex;
+
+	bool is_setup = false;
+	/// `true` when `matches` is up to date with the storages log.
+	bool valid = false;
+	/// The `Pipeline` stage of the last update, see `World::get_dispatch_stage`.
+	uint64_t updated_stage = 0;
+
+	/// The components that can alter the matches of the `Query`.
+	LocalVector<godex::component_id> components;
+	/// The storage of each component, when the cache was updated.
+	LocalVector<StorageBase *> storages;
+	/// The position, into the structural log of each storage, up to which
+	/// the entries are read.
+	LocalVector<uint64_t> cursors;
+
+	LocalVector<EntityID> matches;
+	/// The position of each `Entity` into `matches`.
+	PagedSparseArray match_index;
+
+public:
+	/// Returns a new id, used by each `CachedQuery` type to take its cache.
+	static uint32_t register_cache_id();
+
+	Mutex &get_mutex();
+
+	bool is_set_up() const;
+	/// Takes the components that can alter the matches, from the
+	/// `SystemExeInfo` filled by the `Query`.
+	void setup(const SystemExeInfo &p_info);
+
+	/// Forces a rebuild on the next update.
+	void invalidate();
+
+	/// Returns `true` if the matches need an update during this `Pipeline`
+	/// stage: the structure doesn't change within a stage, so the cache is
+	/// updated once, and the other `System`s of the stage can iterate it.
+	/// Outside a stage (`0`), always `true`.
+	bool needs_update(uint64_t p_stage) const;
+	void set_updated_stage(uint64_t p_stage);
+
+	/// Brings the matches up to date. `p_candidates` returns the `Entities`
+	/// to check when rebuilding, `p_filter` tells if an `Entity` matches.
+	/// Must be called under the mutex.
+	template <class C, class F>
+	void update(World *p_world, C p_candidates, F p_filter);
+
+	const LocalVector<EntityID> &get_matches() const;
+
+private:
+	/// Returns `true` when the log of the storages can't be used.
+	bool fetch_storages(World *p_world);
+	void add_match(EntityID p_entity);
+	void remove_match(EntityID p_entity);
+};
+
+template <class C, class F>
+void QueryCache::update(World *p_world, C p_candidates, F p_filter) {
+	if (fetch_storages(p_world)) {
+		matches.clear();
+		match_index.clear();
+		const EntitiesBuffer candidates = p_candidates();
+		if (candidates.count != UINT32_MAX) {
+			for (uint32_t i = 0; i < candidates.count; i += 1) {
+				if (p_filter(candidates.entities[i])) {
+					add_match(candidates.entities[i]);
+				}
+			}
+		}
+	} else {
+		for (uint32_t s = 0; s < storages.size(); s += 1) {
+			if (storages[s] == nullptr) {
+				continue;
+			}
+			const uint64_t end = storages[s]->get_structural_log_end();
+			for (uint64_t p = cursors[s]; p < end; p += 1) {
+				const EntityID entity = storages[s]->get_structural_log_entry(p);
+				if (p_filter(entity)) {
+					add_match(entity);
+				} else {
+					remove_match(entity);
+				}
+			}
+		}
+	}
+
+	for (uint32_t s = 0; s < storages.size(); s += 1) {
+		cursors[s] = storages[s] == nullptr ? 0 : storages[s]->get_structural_log_end();
+	}
+}
@@ -1,10 +1,10 @@
 #pragma once
 
 #include "../../../components/component.h"
-#include "../../../storage/dense_vector_storage.h"
+#include "../../../storage/tag_storage.h"
 
 // Tag component to mark `Disabled` things.
 struct Disabled {
-	COMPONENT(Disabled, DenseVectorStorage)
+	COMPONENT_TAG(Disabled)
 	static void _bind_methods() {}
 };
@@ -99,7 +99,7 @@ godex::system_id System::get_system_id() const {
 
 uint32_t System::get_current_entity_id() const {
 	ERR_FAIL_COND_V_MSG(info == nullptr, UINT32_MAX, "This systems doesn't seems ready.");
-	return info->get_current_entity_id();
+	return info->get_current_entity_id().get_raw_id();
 }
 
 String System::validate_script(Ref<Script> p_script) {
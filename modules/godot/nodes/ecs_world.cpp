@@ -452,7 +452,7 @@ void WorldECS::unactive_world() {
 
 uint32_t WorldECS::create_entity() {
 	CRASH_COND_MSG(world == nullptr, "The world is never nullptr.");
-	return world->create_entity_index();
+	return world->create_entity_index().get_raw_id();
 }
 
 void WorldECS::destroy_entity(uint32_t p_entity_id) {
@@ -466,7 +466,7 @@ uint32_t WorldECS::create_entity_from_prefab(Object *p_entity) {
 	const Entity3D *entity = cast_to<Entity3D>(p_entity);
 	ERR_FAIL_COND_V_MSG(entity == nullptr, UINT32_MAX, "The passed object is not an `Entity` `Node`.");
 
-	return entity->_create_entity(world);
+	return entity->_create_entity(world).get_raw_id();
 }
 
 void WorldECS::add_component_by_name(uint32_t entity_id, const StringName &p_component_name, const Dictionary &p_data) {
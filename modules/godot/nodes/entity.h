@@ -151,7 +151,7 @@ public:
 		entity._notification(p_what);
 	}
 
-	uint32_t get_entity_id() const { return entity.entity_id; }
+	uint32_t get_entity_id() const { return entity.entity_id.get_raw_id(); }
 
 	void set_components_data(Dictionary p_data) { entity.set_components_data(p_data); }
 	const Dictionary &get_components_data() const { return entity.get_components_data(); }
@@ -242,7 +242,7 @@ public:
 		entity._notification(p_what);
 	}
 
-	uint32_t get_entity_id() const { return entity.entity_id; }
+	uint32_t get_entity_id() const { return entity.entity_id.get_raw_id(); }
 
 	void set_components_data(Dictionary p_data) { entity.set_components_data(p_data); }
 	const Dictionary &get_components_data() const { return entity.get_components_data(); }
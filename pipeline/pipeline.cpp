@@ -3,10 +3,17 @@
 #include "../ecs.h"
 #include "../storage/hierarchical_storage.h"
 #include "../world/world.h"
+#include "core/os/os.h"
+#include "core/os/thread.h"
+#include "thread_pool.h"
 
 Pipeline::Pipeline() {
 }
 
+Pipeline::~Pipeline() {
+	clear_command_buffers();
+}
+
 void Pipeline::set_is_sub_dispatcher(bool p_sub_dispatcher) {
 	is_sub_dispatcher = p_sub_dispatcher;
 }
@@ -40,11 +47,13 @@ uint32_t Pipeline::add_system(func_get_system_exe_info p_func_get_exe_info) {
 #endif
 	const uint32_t in_pipeline_id = systems_info.size();
 	systems_info.push_back(p_func_get_exe_info);
+	systems_name.push_back(StringName());
 	return in_pipeline_id;
 }
 
 uint32_t Pipeline::add_registered_system(godex::system_id p_id) {
 	const uint32_t in_pipeline_id = add_system(ECS::get_func_system_exe_info(p_id));
+	systems_name[in_pipeline_id] = ECS::get_system_name(p_id);
 	if (ECS::is_system_dispatcher(p_id)) {
 		system_dispatchers.push_back(in_pipeline_id);
 	}
@@ -59,8 +68,15 @@ void Pipeline::build() {
 
 	systems_exe.reserve(systems_info.size());
 
+	// The info of each `ExecutionData`, used to compute the stages.
+	LocalVector<SystemExeInfo> exe_infos;
+	exe_infos.reserve(systems_info.size());
+
+	systems_exe_index.resize(systems_info.size());
+
 	SystemExeInfo info;
 	for (uint32_t i = 0; i < systems_info.size(); i += 1) {
+		systems_exe_index[i] = UINT32_MAX;
 		info.clear();
 		systems_info[i](info);
 
@@ -72,13 +88,31 @@ void Pipeline::build() {
 		CRASH_COND_MSG(info.system_func == nullptr, "At this point `info.system_func` is supposed to be not null. To add a system use the following syntax: `add_system(function_name);` or use the `ECS` class to get the `SystemExeInfo` if it's a registered system.");
 #endif
 
+		systems_exe_index[i] = systems_exe.size();
 		systems_exe.resize(systems_exe.size() + 1);
 		ExecutionData &ed = systems_exe[systems_exe.size() - 1];
 
+		if (systems_name[i] != StringName()) {
+			ed.name = systems_name[i];
+		} else if (info.name != StringName()) {
+			ed.name = info.name;
+		} else {
+			ed.name = "System " + itos(i);
+		}
 		ed.exe = info.system_func;
+		if (info.uses_command_buffer) {
+			ed.command_buffer = memnew(CommandBuffer);
+		}
 
 		const bool is_system_dispatcher = system_dispatchers.find(i) != -1;
 
+		if (is_system_dispatcher || info.mutable_databags.has(World::get_databag_id()) || info.immutable_databags.has(World::get_databag_id())) {
+			// The sub pipelines and the `System`s that fetch the `World` can
+			// access anything, so they run alone.
+			info.exclusive = true;
+		}
+		exe_infos.push_back(info);
+
 		if (is_system_dispatcher == false) {
 			// Take the events that are generated by this pipeline
 			// (no sub pipelines).
@@ -107,6 +141,15 @@ void Pipeline::build() {
 				}
 			}
 
+			ed.notify_list_stage_read = ed.notify_list_release_write;
+			for (const Set<uint32_t>::Element *e = info.immutable_components.front(); e; e = e->next()) {
+				if (ECS::storage_notify_release_write(e->get())) {
+					if (ed.notify_list_stage_read.find(e->get()) == -1) {
+						ed.notify_list_stage_read.push_back(e->get());
+					}
+				}
+			}
+
 			// If set: make sure that the `Child` storage (so the `Hierarchy`
 			// storage) is flushed first.
 			const int64_t child_index = ed.notify_list_release_write.find(Child::get_component_id());
@@ -116,6 +159,150 @@ void Pipeline::build() {
 			}
 		}
 	}
+
+	build_stages(exe_infos);
+}
+
+bool Pipeline::is_conflicting(const SystemExeInfo &p_a, const SystemExeInfo &p_b) {
+	if (p_a.exclusive || p_b.exclusive) {
+		return true;
+	}
+
+	// A mutable access conflicts with any other access to the same data.
+	const Set<uint32_t> *a_write[] = { &p_a.mutable_components, &p_a.mutable_components_storage };
+	const Set<uint32_t> *b_write[] = { &p_b.mutable_components, &p_b.mutable_components_storage };
+	const Set<uint32_t> *b_any[] = { &p_b.mutable_components, &p_b.mutable_components_storage, &p_b.immutable_components };
+
+	for (uint32_t a = 0; a < 2; a += 1) {
+		for (const Set<uint32_t>::Element *e = a_write[a]->front(); e; e = e->next()) {
+			for (uint32_t b = 0; b < 3; b += 1) {
+				if (b_any[b]->has(e->get())) {
+					return true;
+				}
+			}
+		}
+	}
+
+	for (const Set<uint32_t>::Element *e = p_a.immutable_components.front(); e; e = e->next()) {
+		for (uint32_t b = 0; b < 2; b += 1) {
+			if (b_write[b]->has(e->get())) {
+				return true;
+			}
+		}
+	}
+
+	for (const Set<uint32_t>::Element *e = p_a.mutable_databags.front(); e; e = e->next()) {
+		if (p_b.mutable_databags.has(e->get()) || p_b.immutable_databags.has(e->get())) {
+			return true;
+		}
+	}
+
+	for (const Set<uint32_t>::Element *e = p_a.immutable_databags.front(); e; e = e->next()) {
+		if (p_b.mutable_databags.has(e->get())) {
+			return true;
+		}
+	}
+
+	return false;
+}
+
+void Pipeline::build_stages(const LocalVector<SystemExeInfo> &p_infos) {
+	CRASH_COND(p_infos.size() != systems_exe.size());
+
+	// The hierarchical storages read the `Hierarchy` when they are released,
+	// so take it into account as dependency.
+	LocalVector<SystemExeInfo> infos = p_infos;
+	for (uint32_t i = 0; i < infos.size(); i += 1) {
+		bool touches_hierarchy = false;
+		for (const Set<uint32_t>::Element *e = infos[i].mutable_components.front(); e && touches_hierarchy == false; e = e->next()) {
+			touches_hierarchy = ECS::storage_notify_release_write(e->get());
+		}
+		for (const Set<uint32_t>::Element *e = infos[i].mutable_components_storage.front(); e && touches_hierarchy == false; e = e->next()) {
+			touches_hierarchy = ECS::storage_notify_release_write(e->get());
+		}
+		for (const Set<uint32_t>::Element *e = infos[i].immutable_components.front(); e && touches_hierarchy == false; e = e->next()) {
+			touches_hierarchy = ECS::storage_notify_release_write(e->get());
+		}
+		if (touches_hierarchy && infos[i].mutable_components.has(Child::get_component_id()) == false && infos[i].mutable_components_storage.has(Child::get_component_id()) == false) {
+			infos[i].immutable_components.insert(Child::get_component_id());
+		}
+
+		// The storages that share their structure (like the `ArchetypeStorage`)
+		// are all altered when a component is added or removed to one of them:
+		// take this into account using `COMPONENT_NONE` as the shared structure.
+		bool writes_structure = false;
+		bool reads_structure = false;
+		for (const Set<uint32_t>::Element *e = infos[i].mutable_components_storage.front(); e; e = e->next()) {
+			writes_structure |= ECS::storage_is_structure_shared(e->get());
+		}
+		for (const Set<uint32_t>::Element *e = infos[i].mutable_components.front(); e; e = e->next()) {
+			reads_structure |= ECS::storage_is_structure_shared(e->get());
+		}
+		for (const Set<uint32_t>::Element *e = infos[i].immutable_components.front(); e; e = e->next()) {
+			reads_structure |= ECS::storage_is_structure_shared(e->get());
+		}
+		if (writes_structure) {
+			infos[i].mutable_components_storage.insert(godex::COMPONENT_NONE);
+		} else if (reads_structure) {
+			infos[i].immutable_components.insert(godex::COMPONENT_NONE);
+		}
+	}
+
+	// Each `System` goes to the stage that follows the last stage containing
+	// a conflicting `System` that comes before it in the pipeline.
+	// An exclusive `System` is a barrier: it takes a stage alone.
+	LocalVector<uint32_t> system_stage;
+	system_stage.resize(infos.size());
+	uint32_t stage_count = 0;
+	uint32_t min_stage = 0;
+	for (uint32_t i = 0; i < infos.size(); i += 1) {
+		uint32_t stage = min_stage;
+		if (infos[i].exclusive) {
+			stage = MAX(stage_count, min_stage);
+			min_stage = stage + 1;
+		} else {
+			for (uint32_t p = 0; p < i; p += 1) {
+				if (system_stage[p] >= stage && is_conflicting(infos[i], infos[p])) {
+					stage = system_stage[p] + 1;
+				}
+			}
+		}
+		system_stage[i] = stage;
+		stage_count = MAX(stage_count, stage + 1);
+	}
+
+	stages_systems.clear();
+	stages_offsets.clear();
+	stages_systems.reserve(infos.size());
+	stages_offsets.reserve(stage_count + 1);
+	for (uint32_t s = 0; s < stage_count; s += 1) {
+		stages_offsets.push_back(stages_systems.size());
+		for (uint32_t i = 0; i < infos.size(); i += 1) {
+			if (system_stage[i] == s) {
+				stages_systems.push_back(i);
+			}
+		}
+	}
+	stages_offsets.push_back(stages_systems.size());
+}
+
+uint32_t Pipeline::get_stage_count() const {
+	return stages_offsets.size() == 0 ? 0 : stages_offsets.size() - 1;
+}
+
+uint32_t Pipeline::get_system_stage(uint32_t p_system) const {
+	ERR_FAIL_UNSIGNED_INDEX_V(p_system, systems_info.size(), UINT32_MAX);
+	if (p_system >= systems_exe_index.size() || systems_exe_index[p_system] == UINT32_MAX) {
+		return UINT32_MAX;
+	}
+	for (uint32_t s = 0; s < get_stage_count(); s += 1) {
+		for (uint32_t i = stages_offsets[s]; i < stages_offsets[s + 1]; i += 1) {
+			if (stages_systems[i] == systems_exe_index[p_system]) {
+				return s;
+			}
+		}
+	}
+	return UINT32_MAX;
 }
 
 bool Pipeline::is_ready() const {
@@ -129,8 +316,13 @@ void Pipeline::get_systems_dependencies(SystemExeInfo &p_info) const {
 }
 
 void Pipeline::reset() {
+	clear_command_buffers();
 	systems_info.clear();
+	systems_name.clear();
 	systems_exe.clear();
+	systems_exe_index.clear();
+	stages_systems.clear();
+	stages_offsets.clear();
 	ready = false;
 }
 
@@ -143,9 +335,18 @@ void Pipeline::prepare(World *p_world) {
 		}
 	}
 
+	// The ticks are relative to the `World`: start from scratch, so the
+	// `System`s see all the changes the first time.
+	for (uint32_t i = 0; i < systems_exe.size(); i += 1) {
+		systems_exe[i].last_run_tick = 0;
+	}
+
 	// Crete components and databags storages.
+	systems_exe_index.resize(systems_info.size());
+
 	SystemExeInfo info;
 	for (uint32_t i = 0; i < systems_info.size(); i += 1) {
+		systems_exe_index[i] = UINT32_MAX;
 		info.clear();
 		systems_info[i](info);
 
@@ -204,6 +405,15 @@ void Pipeline::dispatch(World *p_world) {
 		hierarchy->flush_hierarchy_changes();
 	}
 
+	// The `World` forgets the changes older than this tick: the `System`s
+	// that didn't run since then see all the remaining changes.
+	const uint32_t oldest_tick = p_world->get_oldest_change_tick();
+	for (uint32_t i = 0; i < systems_exe.size(); i += 1) {
+		if (StorageBase::is_tick_newer(oldest_tick, systems_exe[i].last_run_tick)) {
+			systems_exe[i].last_run_tick = oldest_tick;
+		}
+	}
+
 	// Process the `TemporarySystem`, if any.
 	for (int i = 0; i < int(temporary_systems_exe.size()); i += 1) {
 		if (temporary_systems_exe[i](p_world)) {
@@ -212,30 +422,127 @@ void Pipeline::dispatch(World *p_world) {
 		}
 	}
 
-	// Dispatch the `System`s.
-	for (uint32_t i = 0; i < systems_exe.size(); i += 1) {
-		const ExecutionData &ed = systems_exe[i];
-		ed.exe(p_world);
+	// The sub pipelines are profiled as part of the dispatcher `System`.
+	PipelineProfiler *profiler = is_sub_dispatcher ? nullptr : p_world->get_databag<PipelineProfiler>();
+	PipelineProfiler::Frame *profile = nullptr;
+	if (profiler != nullptr && profiler->is_enabled()) {
+		profile = &profiler->begin_frame(systems_exe.size());
+		profile->begin_usec = OS::get_singleton()->get_ticks_usec();
+	}
+
+	// Dispatch the `System`s, stage by stage. A sub pipeline runs inside the
+	// stage of its dispatcher, so restore it at the end.
+	const uint64_t previous_stage = p_world->dispatch_stage;
+	for (uint32_t s = 0; s < get_stage_count(); s += 1) {
+		p_world->dispatch_stage_counter += 1;
+		p_world->dispatch_stage = p_world->dispatch_stage_counter;
+
+		const uint32_t from = stages_offsets[s];
+		const uint32_t count = stages_offsets[s + 1] - from;
+		const StageJob job{ p_world, s, from, profile };
+
+		// Let the storages taken by this stage settle their pending changes,
+		// while no `System` is running.
+		for (uint32_t i = 0; i < count; i += 1) {
+			const ExecutionData &ed = systems_exe[stages_systems[from + i]];
+			for (uint32_t r = 0; r < ed.notify_list_stage_read.size(); r += 1) {
+				StorageBase *storage = p_world->get_storage(ed.notify_list_stage_read[r]);
+				if (storage != nullptr) {
+					storage->on_stage_read();
+				}
+			}
+		}
+
+		if (count == 1 || godex::ThreadPool::do_work(count, this, &Pipeline::dispatch_stage_system, job) == false) {
+			for (uint32_t i = 0; i < count; i += 1) {
+				execute_system(stages_systems[from + i], job);
+			}
+		}
 
-		// Notify the `System` released the storage.
-		for (uint32_t f = 0; f < ed.notify_list_release_write.size(); f += 1) {
-			p_world->get_storage(ed.notify_list_release_write[f])->on_system_release();
+		// Notify the `System`s of this stage released the storages.
+		for (uint32_t i = 0; i < count; i += 1) {
+			const ExecutionData &ed = systems_exe[stages_systems[from + i]];
+			const uint64_t release_begin = profile ? OS::get_singleton()->get_ticks_usec() : 0;
+			for (uint32_t f = 0; f < ed.notify_list_release_write.size(); f += 1) {
+				p_world->get_storage(ed.notify_list_release_write[f])->on_system_release();
+			}
+			if (profile) {
+				profile->systems[stages_systems[from + i]].release_usec = OS::get_singleton()->get_ticks_usec() - release_begin;
+			}
+		}
+
+		// Sync point: apply the structural changes recorded by this stage, in
+		// the `System`s order.
+		for (uint32_t i = 0; i < count; i += 1) {
+			CommandBuffer *command_buffer = systems_exe[stages_systems[from + i]].command_buffer;
+			if (command_buffer != nullptr && command_buffer->is_empty() == false) {
+				p_world->apply_commands(*command_buffer);
+			}
 		}
 	}
 
+	p_world->dispatch_stage = previous_stage;
+
 	// Clear any generated component storages.
 	for (uint32_t c = 0; c < event_generator.size(); c += 1) {
 		p_world->get_storage(event_generator[c])->clear();
 	}
 
-	// Flush changed.
-	if (is_sub_dispatcher == false) {
-		for (uint32_t c = 0; c < p_world->storages.size(); c += 1) {
-			if (p_world->storages[c] != nullptr) {
-				p_world->storages[c]->flush_changed();
-			}
-		}
+	if (profile) {
+		profile->time_usec = OS::get_singleton()->get_ticks_usec() - profile->begin_usec;
+		profiler->end_frame();
 	}
 
 	p_world->is_dispatching_in_progress = false;
 }
+
+void Pipeline::dispatch_stage_system(uint32_t p_index, StageJob p_job) {
+	execute_system(stages_systems[p_job.stage_offset + p_index], p_job);
+}
+
+void Pipeline::execute_system(uint32_t p_system, const StageJob &p_job) {
+	ExecutionData &ed = systems_exe[p_system];
+
+	PipelineProfiler::SystemRecord *record = nullptr;
+	if (p_job.profile) {
+		record = &p_job.profile->systems[p_system];
+		record->name = ed.name;
+		record->stage = p_job.stage;
+		record->thread = Thread::get_caller_id();
+		record->entities = 0;
+		record->release_usec = 0;
+		PipelineProfiler::set_entities_counter(&record->entities);
+		record->begin_usec = OS::get_singleton()->get_ticks_usec();
+	}
+
+	// Each execution takes a new tick: the changes are stamped with it, and
+	// `Changed` compares them with the tick of the previous execution.
+	uint32_t tick = p_job.world->change_tick.fetch_add(1, std::memory_order_relaxed) + 1;
+	if (unlikely(tick == 0)) {
+		// The counter wrapped: `0` means outside a `System`.
+		tick = p_job.world->change_tick.fetch_add(1, std::memory_order_relaxed) + 1;
+	}
+	const SystemTicks previous_ticks = StorageBase::set_system_ticks({ tick, ed.last_run_tick });
+
+	// Each `System` records into its own buffer, so no lock is needed.
+	CommandBuffer *previous_buffer = CommandBuffer::set_current(ed.command_buffer);
+	ed.exe(p_job.world);
+	CommandBuffer::set_current(previous_buffer);
+
+	StorageBase::set_system_ticks(previous_ticks);
+	ed.last_run_tick = tick;
+
+	if (record) {
+		record->time_usec = OS::get_singleton()->get_ticks_usec() - record->begin_usec;
+		PipelineProfiler::set_entities_counter(nullptr);
+	}
+}
+
+void Pipeline::clear_command_buffers() {
+	for (uint32_t i = 0; i < systems_exe.size(); i += 1) {
+		if (systems_exe[i].command_buffer != nullptr) {
+			memdelete(systems_exe[i].command_buffer);
+			systems_exe[i].command_buffer = nullptr;
+		}
+	}
+}
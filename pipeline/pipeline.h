@@ -3,13 +3,33 @@
 #include "../ecs.h"
 #include "../systems/system.h"
 #include "core/templates/local_vector.h"
+#include "pipeline_profiler.h"
 
 class World;
+class CommandBuffer;
+
+struct StageJob {
+	World *world;
+	uint32_t stage;
+	uint32_t stage_offset;
+	/// The frame to record into, `nullptr` when the profiler is disabled.
+	PipelineProfiler::Frame *profile;
+};
 
 struct ExecutionData {
+	StringName name;
 	func_system_execute exe;
 	/// Storages that want to be notified at the end of the `System` execution.
 	LocalVector<godex::component_id> notify_list_release_write;
+	/// Storages that want to be notified before the stage of this `System`,
+	/// since it takes them (see `StorageBase::on_stage_read`).
+	LocalVector<godex::component_id> notify_list_stage_read;
+	/// The commands recorded by the `System`, applied at the end of its stage.
+	/// `nullptr` if the `System` doesn't use a `CommandBuffer`.
+	CommandBuffer *command_buffer = nullptr;
+	/// The change tick of the last execution, `0` if never executed: the
+	/// `Changed` filter returns the components changed after it.
+	uint32_t last_run_tick = 0;
 };
 
 class Pipeline {
@@ -19,7 +39,12 @@ class Pipeline {
 
 	/// Execution information.
 	LocalVector<func_get_system_exe_info> systems_info;
+	/// The names of the registered `System`s, empty for the others.
+	LocalVector<StringName> systems_name;
 	LocalVector<ExecutionData> systems_exe;
+	/// The `systems_exe` index of each added `System`, `UINT32_MAX` if it's
+	/// invalid and so excluded from the pipeline.
+	LocalVector<uint32_t> systems_exe_index;
 
 	/// List of systems that executes a sub pipeline.
 	LocalVector<uint32_t> system_dispatchers;
@@ -28,8 +53,20 @@ class Pipeline {
 	/// cleared at the end of the dispatch.
 	LocalVector<uint32_t> event_generator;
 
+	/// The systems are grouped in stages: the systems of a stage don't
+	/// conflict with each other, so they run concurrently.
+	/// `stages_systems` contains the `systems_exe` indices ordered by stage,
+	/// the stage `S` goes from `stages_offsets[S]` to `stages_offsets[S + 1]`.
+	LocalVector<uint32_t> stages_systems;
+	LocalVector<uint32_t> stages_offsets;
+
 public:
 	Pipeline();
+	/// The `Pipeline` owns the `CommandBuffer`s of its systems: it can't be
+	/// copied.
+	Pipeline(const Pipeline &) = delete;
+	Pipeline &operator=(const Pipeline &) = delete;
+	~Pipeline();
 
 	void set_is_sub_dispatcher(bool p_sub_dispatcher);
 	bool get_is_sub_dispatcher() const;
@@ -68,6 +105,21 @@ public:
 
 	/// Dispatch the pipeline on the following world.
 	void dispatch(World *p_world);
+
+	/// Returns the amount of stages: the systems of the same stage are
+	/// executed concurrently.
+	uint32_t get_stage_count() const;
+
+	/// Returns the stage of the `System` with the passed in pipeline ID, or
+	/// `UINT32_MAX` if it's not part of the built pipeline.
+	uint32_t get_system_stage(uint32_t p_system) const;
+
+private:
+	static bool is_conflicting(const SystemExeInfo &p_a, const SystemExeInfo &p_b);
+	void build_stages(const LocalVector<SystemExeInfo> &p_infos);
+	void dispatch_stage_system(uint32_t p_index, StageJob p_job);
+	void execute_system(uint32_t p_system, const StageJob &p_job);
+	void clear_command_buffers();
 };
 
 // This macro save the user the need to pass a `SystemExeInfo`, indeed it wraps
@@ -88,6 +140,7 @@ public:
 #define add_system(func)                                            \
 	add_system([](SystemExeInfo &r_info) {                          \
 		SystemBuilder::get_system_info_from_function(r_info, func); \
+		r_info.name = #func;                                        \
 		r_info.system_func = [](World *p_world) {                   \
 			SystemBuilder::system_exec_func(p_world, func);         \
 		};                                                          \
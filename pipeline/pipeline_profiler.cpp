@@ -0,0 +1,105 @@
+#include "pipeline_profiler.h"
+
+thread_local uint32_t *PipelineProfiler::entities_counter = nullptr;
+
+void PipelineProfiler::_bind_methods() {
+	add_method("set_enabled", &PipelineProfiler::set_enabled);
+	add_method("is_enabled", &PipelineProfiler::is_enabled);
+	add_method("set_capacity", &PipelineProfiler::set_capacity);
+	add_method("get_capacity", &PipelineProfiler::get_capacity);
+	add_method("clear", &PipelineProfiler::clear);
+	add_method("get_frame_count", &PipelineProfiler::get_frame_count);
+	add_method("get_chrome_trace", &PipelineProfiler::get_chrome_trace);
+}
+
+PipelineProfiler::PipelineProfiler() {
+	frames.resize(300);
+}
+
+void PipelineProfiler::set_enabled(bool p_enabled) {
+	enabled = p_enabled;
+}
+
+bool PipelineProfiler::is_enabled() const {
+	return enabled;
+}
+
+void PipelineProfiler::set_capacity(uint32_t p_frames) {
+	ERR_FAIL_COND_MSG(p_frames == 0, "The profiler needs to keep at least one frame.");
+	clear();
+	frames.resize(p_frames);
+}
+
+uint32_t PipelineProfiler::get_capacity() const {
+	return frames.size();
+}
+
+void PipelineProfiler::clear() {
+	frame_head = 0;
+	frame_count = 0;
+}
+
+uint32_t PipelineProfiler::get_frame_count() const {
+	return frame_count;
+}
+
+const PipelineProfiler::Frame &PipelineProfiler::get_frame(uint32_t p_index) const {
+	CRASH_COND_MSG(p_index >= frame_count, "The frame " + itos(p_index) + " is not recorded.");
+	const uint32_t oldest = (frame_head + frames.size() - frame_count) % frames.size();
+	return frames[(oldest + p_index) % frames.size()];
+}
+
+const PipelineProfiler::Frame &PipelineProfiler::get_last_frame() const {
+	return get_frame(frame_count - 1);
+}
+
+String PipelineProfiler::get_chrome_trace() const {
+	String trace = "{\"traceEvents\":[";
+	bool first = true;
+	for (uint32_t f = 0; f < frame_count; f += 1) {
+		const Frame &frame = get_frame(f);
+
+		if (first == false) {
+			trace += ",";
+		}
+		first = false;
+		trace += "{\"name\":\"Frame\",\"cat\":\"frame\",\"ph\":\"X\",\"pid\":0,\"tid\":0";
+		trace += ",\"ts\":" + itos(frame.begin_usec) + ",\"dur\":" + itos(frame.time_usec);
+		trace += ",\"args\":{\"flush_usec\":" + itos(frame.flush_usec) + "}}";
+
+		for (uint32_t s = 0; s < frame.systems.size(); s += 1) {
+			const SystemRecord &record = frame.systems[s];
+			trace += ",{\"name\":\"" + String(record.name).json_escape() + "\",\"cat\":\"system\",\"ph\":\"X\",\"pid\":0";
+			trace += ",\"tid\":" + itos(record.thread);
+			trace += ",\"ts\":" + itos(record.begin_usec) + ",\"dur\":" + itos(record.time_usec);
+			trace += ",\"args\":{\"stage\":" + itos(record.stage);
+			trace += ",\"entities\":" + itos(record.entities);
+			trace += ",\"release_usec\":" + itos(record.release_usec) + "}}";
+		}
+	}
+	trace += "]}";
+	return trace;
+}
+
+PipelineProfiler::Frame &PipelineProfiler::begin_frame(uint32_t p_systems) {
+	Frame &frame = frames[frame_head];
+	frame.begin_usec = 0;
+	frame.time_usec = 0;
+	frame.flush_usec = 0;
+	frame.systems.resize(p_systems);
+	return frame;
+}
+
+void PipelineProfiler::end_frame() {
+	frame_head = (frame_head + 1) % frames.size();
+	frame_count = MIN(frame_count + 1, frames.size());
+}
+
+void PipelineProfiler::set_flush_time(uint64_t p_usec) {
+	ERR_FAIL_COND_MSG(frame_count == 0, "No frame recorded.");
+	frames[(frame_head + frames.size() - 1) % frames.size()].flush_usec = p_usec;
+}
+
+void PipelineProfiler::set_entities_counter(uint32_t *p_counter) {
+	entities_counter = p_counter;
+}
@@ -0,0 +1,95 @@
+#pragma once
+
+#include "../databags/databag.h"
+#include "core/string/string_name.h"
+#include "core/templates/local_vector.h"
+
+/// Records the execution time of each `System` of a `Pipeline`, for the last
+/// frames. It's opt-in: add this databag to the `World` and enable it.
+/// ```
+/// world.create_databag<PipelineProfiler>().set_enabled(true);
+/// ```
+///
+/// The frames are stored in a ring buffer, and can be exported with
+/// `get_chrome_trace` to be inspected with `chrome://tracing`.
+class PipelineProfiler : public godex::Databag {
+	DATABAG(PipelineProfiler)
+
+	static void _bind_methods();
+
+public:
+	struct SystemRecord {
+		StringName name;
+		uint32_t stage = 0;
+		uint64_t thread = 0;
+		uint64_t begin_usec = 0;
+		uint64_t time_usec = 0;
+		/// The amount of `Entities` the `Query`s of this `System` had to check.
+		uint32_t entities = 0;
+		/// The time taken by the storages to flush, once the `System` released
+		/// them (see `StorageBase::on_system_release`).
+		uint64_t release_usec = 0;
+	};
+
+	struct Frame {
+		uint64_t begin_usec = 0;
+		uint64_t time_usec = 0;
+		/// The time taken by `World::flush`, if dispatched by the `ECS`.
+		uint64_t flush_usec = 0;
+		LocalVector<SystemRecord> systems;
+	};
+
+private:
+	bool enabled = false;
+	LocalVector<Frame> frames;
+	/// The slot of the next frame.
+	uint32_t frame_head = 0;
+	uint32_t frame_count = 0;
+
+	/// Set while a `System` is profiled, counts the `Entities` checked by the
+	/// `Query`s created on this thread.
+	static thread_local uint32_t *entities_counter;
+
+public:
+	PipelineProfiler();
+
+	void set_enabled(bool p_enabled);
+	bool is_enabled() const;
+
+	/// Sets the amount of frames to keep, the oldest ones are dropped.
+	void set_capacity(uint32_t p_frames);
+	uint32_t get_capacity() const;
+
+	/// Drops all the recorded frames.
+	void clear();
+
+	/// Returns the amount of recorded frames.
+	uint32_t get_frame_count() const;
+
+	/// Returns the recorded frame, `0` is the oldest one.
+	const Frame &get_frame(uint32_t p_index) const;
+
+	/// Returns the last recorded frame.
+	const Frame &get_last_frame() const;
+
+	/// Returns the recorded frames using the Chrome trace event format (JSON).
+	String get_chrome_trace() const;
+
+	/// Starts a new frame, overwriting the oldest one if the buffer is full.
+	/// The returned `Frame` has a `SystemRecord` for each `System`: each
+	/// `System` writes only its own record, so they can be set concurrently.
+	Frame &begin_frame(uint32_t p_systems);
+	void end_frame();
+
+	/// Sets the flush time of the last frame.
+	void set_flush_time(uint64_t p_usec);
+
+	/// Used by the `Pipeline` to count the `Entities` checked by a `System`.
+	static void set_entities_counter(uint32_t *p_counter);
+
+	static _FORCE_INLINE_ void count_entities(uint32_t p_count) {
+		if (unlikely(entities_counter != nullptr)) {
+			*entities_counter += p_count;
+		}
+	}
+};
@@ -0,0 +1,63 @@
+#include "thread_pool.h"
+
+#include "core/os/os.h"
+
+ThreadWorkPool *godex::ThreadPool::pool = nullptr;
+std::atomic<bool> godex::ThreadPool::busy(false);
+bool godex::ThreadPool::enabled = true;
+
+void godex::ThreadPool::set_enabled(bool p_enabled) {
+	enabled = p_enabled;
+}
+
+bool godex::ThreadPool::is_enabled() {
+	return enabled;
+}
+
+uint32_t godex::ThreadPool::get_thread_count() {
+	if (pool) {
+		return pool->get_thread_count();
+	}
+	return OS::get_singleton()->get_processor_count();
+}
+
+bool godex::ThreadPool::is_busy() {
+	return busy.load(std::memory_order_acquire);
+}
+
+void godex::ThreadPool::finish() {
+	ERR_FAIL_COND_MSG(is_busy(), "The thread pool can't be released while executing a job.");
+	if (pool) {
+		pool->finish();
+		memdelete(pool);
+		pool = nullptr;
+	}
+}
+
+bool godex::ThreadPool::acquire() {
+	if (enabled == false) {
+		return false;
+	}
+
+	bool expected = false;
+	if (busy.compare_exchange_strong(expected, true, std::memory_order_acq_rel) == false) {
+		// Already executing a job.
+		return false;
+	}
+
+	if (unlikely(pool == nullptr)) {
+		if (OS::get_singleton()->get_processor_count() <= 1) {
+			// Nothing to gain.
+			busy.store(false, std::memory_order_release);
+			return false;
+		}
+		pool = memnew(ThreadWorkPool);
+		pool->init();
+	}
+
+	return true;
+}
+
+void godex::ThreadPool::release() {
+	busy.store(false, std::memory_order_release);
+}
@@ -0,0 +1,62 @@
+#pragma once
+
+#include "core/templates/thread_work_pool.h"
+#include <atomic>
+
+namespace godex {
+
+/// Worker pool shared by the `Pipeline` (to execute the stages) and by the
+/// `Query::par_for_each`.
+///
+/// The work is self scheduled: each worker fetches the next element index from
+/// a shared atomic counter, so the threads that finish early keep taking
+/// elements from the threads that are still busy.
+///
+/// The pool can't be used recursively: a job submitted while the pool is
+/// already executing another job (for example a `Query::par_for_each` fired by
+/// a `System` that is running on a worker) is rejected, and the caller is
+/// supposed to execute it on the current thread.
+class ThreadPool {
+	static ThreadWorkPool *pool;
+	static std::atomic<bool> busy;
+	static bool enabled;
+
+public:
+	/// Enable or disable the multithreaded execution. When disabled, `do_work`
+	/// always returns `false`.
+	static void set_enabled(bool p_enabled);
+	static bool is_enabled();
+
+	/// Returns the amount of workers.
+	static uint32_t get_thread_count();
+
+	/// Executes `p_method` on `p_instance`, passing each index from 0 to
+	/// `p_elements`, using all the available workers; it returns once all the
+	/// elements are processed.
+	/// Returns `false` without executing anything when the pool is disabled or
+	/// already busy: in this case, the caller has to process the elements.
+	template <class C, class M, class U>
+	static bool do_work(uint32_t p_elements, C *p_instance, M p_method, U p_userdata);
+
+	/// Returns `true` if the pool is executing a job.
+	static bool is_busy();
+
+	/// Stops the workers and releases the pool.
+	static void finish();
+
+private:
+	static bool acquire();
+	static void release();
+};
+
+template <class C, class M, class U>
+bool ThreadPool::do_work(uint32_t p_elements, C *p_instance, M p_method, U p_userdata) {
+	if (acquire() == false) {
+		return false;
+	}
+	pool->do_work(p_elements, p_instance, p_method, p_userdata);
+	release();
+	return true;
+}
+
+} // namespace godex
@@ -8,6 +8,8 @@
 #include "iterators/dynamic_query.h"
 #include "modules/ecs_modules_register.h"
 #include "modules/godot/editor_plugins/components_gizmo_3d.h"
+#include "pipeline/pipeline_profiler.h"
+#include "pipeline/thread_pool.h"
 #include "systems/dynamic_system.h"
 
 Ref<Components3DGizmoPlugin> component_gizmo;
@@ -30,6 +32,7 @@ void register_godex_types() {
 
 	ECS::register_databag<WorldCommands>();
 	ECS::register_databag<World>();
+	ECS::register_databag<PipelineProfiler>();
 
 	ecs_register_modules();
 }
@@ -41,6 +44,9 @@ void unregister_godex_types() {
 	godex::__dynamic_system_info_static_destructor();
 	godex::DynamicSystemInfo::for_each_name = StringName();
 
+	// Stop the workers.
+	godex::ThreadPool::finish();
+
 	// Clear ECS static memory.
 	ECS::__static_destructor();
 	ECS *ecs = ECS::get_singleton();
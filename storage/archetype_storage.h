@@ -0,0 +1,179 @@
+#pragma once
+
+#include "archetype_table.h"
+#include "core/os/mutex.h"
+#include "storage.h"
+#include <atomic>
+
+/// Base class of the `ArchetypeStorage`, used by the `World` to assign the
+/// shared `ArchetypeTable`.
+class ArchetypeStorageBase {
+	friend class World;
+
+protected:
+	ArchetypeTable *table = nullptr;
+	ArchetypeTable *owned_table = nullptr;
+
+public:
+	virtual ~ArchetypeStorageBase() {
+		if (owned_table) {
+			memdelete(owned_table);
+		}
+	}
+
+	virtual ArchetypeColumnInfo get_column_info() const = 0;
+
+	void set_table(ArchetypeTable *p_table) {
+		CRASH_COND_MSG(table != nullptr, "This storage already has its `ArchetypeTable`.");
+		table = p_table;
+		table->register_column(get_column_info());
+	}
+
+	ArchetypeTable *get_table() {
+		if (unlikely(table == nullptr)) {
+			// This storage is used alone, without a `World`.
+			owned_table = memnew(ArchetypeTable);
+			set_table(owned_table);
+		}
+		return table;
+	}
+
+	const ArchetypeTable *get_table() const {
+		return table;
+	}
+};
+
+/// The `ArchetypeStorage` doesn't store the components itself: all the
+/// `ArchetypeStorage`s of a `World` share the same `ArchetypeTable`, that
+/// packs the components of the entities having the same set of components
+/// into the same chunks.
+///
+/// Use it for components that are often queried together: the `Query`
+/// iterates the entities in memory order, so fetching many components of the
+/// same `Entity` streams the memory.
+/// On the other hand, adding or removing a component moves all the components
+/// of the `Entity` to another archetype, so it's slower than the other storages.
+///
+/// ```
+/// struct Velocity {
+/// 	COMPONENT(Velocity, ArchetypeStorage)
+/// 	Vector3 velocity;
+/// };
+/// ```
+template <class T>
+class ArchetypeStorage : public Storage<T>, public ArchetypeStorageBase {
+	/// The entities that have this component, in memory order.
+	mutable LocalVector<EntityID> entities;
+	mutable std::atomic<uint64_t> entities_version;
+	mutable Mutex entities_mutex;
+
+public:
+	ArchetypeStorage() :
+			entities_version(UINT64_MAX) {}
+
+	virtual void configure(const Dictionary &p_config) override {
+		get_table()->set_chunk_size(p_config.get("chunk_size", 16 * 1024));
+	}
+
+	virtual String get_type_name() const override {
+		return "ArchetypeStorage[" + String(typeid(T).name()) + "]";
+	}
+
+	virtual bool is_structure_shared() const override {
+		return true;
+	}
+
+	virtual ArchetypeColumnInfo get_column_info() const override {
+		ArchetypeColumnInfo info;
+		info.id = T::get_component_id();
+		info.size = sizeof(T);
+		info.alignment = alignof(T);
+		info.copy_construct = [](void *p_dst, const void *p_src) {
+			memnew_placement(p_dst, T(*static_cast<const T *>(p_src)));
+		};
+		info.destroy = [](void *p_data) {
+			static_cast<T *>(p_data)->~T();
+		};
+		return info;
+	}
+
+	virtual bool notifies_entity_signature() const override {
+		return true;
+	}
+
+	virtual void insert(EntityID p_entity, const T &p_data) override {
+		get_table()->insert(p_entity, T::get_component_id(), &p_data);
+		StorageBase::notify_changed(p_entity);
+		StorageBase::notify_inserted(p_entity);
+	}
+
+	virtual bool has(EntityID p_entity) const override {
+		return table != nullptr && table->has(p_entity, T::get_component_id());
+	}
+
+	virtual T *get(EntityID p_entity, Space p_mode = Space::LOCAL) override {
+		StorageBase::notify_changed(p_entity);
+		T *data = static_cast<T *>(get_table()->get(p_entity, T::get_component_id()));
+		CRASH_COND_MSG(data == nullptr, "This entity doesn't have anything stored, before get the data you have to use `has()`.");
+		return data;
+	}
+
+	virtual const T *get(EntityID p_entity, Space p_mode = Space::LOCAL) const override {
+		const T *data = table == nullptr ? nullptr : static_cast<const T *>(table->get(p_entity, T::get_component_id()));
+		CRASH_COND_MSG(data == nullptr, "This entity doesn't have anything stored, before get the data you have to use `has()`.");
+		return data;
+	}
+
+	virtual void remove(EntityID p_entity) override {
+		if (table != nullptr) {
+			table->remove(p_entity, T::get_component_id());
+		}
+		// Make sure to remove as changed.
+		StorageBase::notify_updated(p_entity);
+		StorageBase::notify_removed(p_entity);
+	}
+
+	virtual void remove_batch(const EntityID *p_entities, uint32_t p_count) override {
+		// The entities may be already removed from the table, when destroyed
+		// by the `World`: still make sure to update the changed list.
+		for (uint32_t i = 0; i < p_count; i += 1) {
+			remove(p_entities[i]);
+		}
+	}
+
+	virtual void clear() override {
+		StorageBase::notify_removed_all();
+		if (table != nullptr) {
+			const EntitiesBuffer stored = get_stored_entities();
+			// Copy the entities, since the list is updated while removing.
+			LocalVector<EntityID> to_remove;
+			to_remove.resize(stored.count);
+			for (uint32_t i = 0; i < stored.count; i += 1) {
+				to_remove[i] = stored.entities[i];
+			}
+			for (uint32_t i = 0; i < to_remove.size(); i += 1) {
+				table->remove(to_remove[i], T::get_component_id());
+			}
+		}
+		StorageBase::flush_changed();
+	}
+
+	virtual EntitiesBuffer get_stored_entities() const override {
+		if (table == nullptr) {
+			return { 0, nullptr };
+		}
+
+		const uint64_t version = table->get_structure_version();
+		if (entities_version.load(std::memory_order_acquire) != version) {
+			// The table structure changed, rebuild the list. This storage may
+			// be read concurrently by many `System`s of the same stage.
+			MutexLock lock(entities_mutex);
+			if (entities_version.load(std::memory_order_relaxed) != version) {
+				entities.clear();
+				table->fetch_entities(T::get_component_id(), entities);
+				entities_version.store(version, std::memory_order_release);
+			}
+		}
+		return { entities.size(), entities.ptr() };
+	}
+};
@@ -0,0 +1,299 @@
+#include "archetype_table.h"
+
+#include "core/os/memory.h"
+
+Archetype::~Archetype() {
+	// Destroy the stored components.
+	for (uint32_t row = 0; row < size; row += 1) {
+		for (uint32_t c = 0; c < columns.size(); c += 1) {
+			columns[c].destroy(get_component(c, row));
+		}
+	}
+	for (uint32_t i = 0; i < chunks.size(); i += 1) {
+		memfree(chunks[i]);
+	}
+}
+
+void Archetype::setup(const LocalVector<ArchetypeColumnInfo> &p_columns, uint32_t p_chunk_size) {
+	columns = p_columns;
+
+	signature.resize(columns.size());
+	uint32_t row_size = sizeof(EntityID);
+	godex::component_id biggest_id = 0;
+	for (uint32_t c = 0; c < columns.size(); c += 1) {
+		signature[c] = columns[c].id;
+		row_size += columns[c].size;
+		biggest_id = MAX(biggest_id, columns[c].id);
+	}
+
+	component_to_column.resize(biggest_id + 1);
+	for (uint32_t i = 0; i < component_to_column.size(); i += 1) {
+		component_to_column[i] = -1;
+	}
+	for (uint32_t c = 0; c < columns.size(); c += 1) {
+		component_to_column[columns[c].id] = c;
+	}
+
+	// The capacity is the biggest power of two that fits the chunk size.
+	chunk_shift = 0;
+	while ((row_size << (chunk_shift + 1)) <= p_chunk_size) {
+		chunk_shift += 1;
+	}
+	chunk_mask = (1 << chunk_shift) - 1;
+	const uint32_t capacity = chunk_mask + 1;
+
+	// Compute the column offsets.
+	uint32_t offset = sizeof(EntityID) * capacity;
+	column_offsets.resize(columns.size());
+	for (uint32_t c = 0; c < columns.size(); c += 1) {
+		const uint32_t alignment = MAX(columns[c].alignment, 1u);
+		offset = ((offset + alignment - 1) / alignment) * alignment;
+		column_offsets[c] = offset;
+		offset += columns[c].size * capacity;
+	}
+	chunk_memory_size = offset;
+}
+
+uint32_t Archetype::push_row(EntityID p_entity) {
+	const uint32_t row = size;
+	if ((row >> chunk_shift) >= chunks.size()) {
+		chunks.push_back(static_cast<uint8_t *>(memalloc(chunk_memory_size)));
+	}
+	size += 1;
+	get_entity(row) = p_entity;
+	return row;
+}
+
+ArchetypeTable::~ArchetypeTable() {
+	for (uint32_t i = 0; i < archetypes.size(); i += 1) {
+		memdelete(archetypes[i]);
+	}
+}
+
+void ArchetypeTable::set_chunk_size(uint32_t p_chunk_size) {
+	chunk_size = MAX(p_chunk_size, 1024u);
+}
+
+void ArchetypeTable::register_column(const ArchetypeColumnInfo &p_info) {
+	ERR_FAIL_COND_MSG(p_info.id == godex::COMPONENT_NONE, "The component is not registered.");
+	if (p_info.id >= columns_info.size()) {
+		const uint32_t start = columns_info.size();
+		columns_info.resize(p_info.id + 1);
+		single_component_archetypes.resize(p_info.id + 1);
+		for (uint32_t i = start; i < columns_info.size(); i += 1) {
+			columns_info[i] = ArchetypeColumnInfo();
+			single_component_archetypes[i] = UINT32_MAX;
+		}
+	}
+	columns_info[p_info.id] = p_info;
+}
+
+void ArchetypeTable::insert(EntityID p_entity, godex::component_id p_component, const void *p_data) {
+	ERR_FAIL_COND_MSG(p_component >= columns_info.size() || columns_info[p_component].id == godex::COMPONENT_NONE, "The component " + itos(p_component) + " is not registered into the `ArchetypeTable`.");
+
+	const uint32_t index = p_entity;
+	if (index >= locations.size()) {
+		const uint32_t start = locations.size();
+		locations.resize(index + 1);
+		for (uint32_t i = start; i < locations.size(); i += 1) {
+			locations[i] = Location();
+		}
+	}
+
+	const uint32_t from = locations[index].archetype;
+	if (from != UINT32_MAX) {
+		Archetype *archetype = archetypes[from];
+		const int32_t column = archetype->get_column(p_component);
+		if (column != -1) {
+			// Already stored, just replace it.
+			void *ptr = archetype->get_component(column, locations[index].row);
+			columns_info[p_component].destroy(ptr);
+			columns_info[p_component].copy_construct(ptr, p_data);
+			return;
+		}
+	}
+
+	const uint32_t to = get_transition(from, p_component, true);
+	const uint32_t row = move_entity(p_entity, to);
+
+	Archetype *archetype = archetypes[to];
+	columns_info[p_component].copy_construct(
+			archetype->get_component(archetype->get_column(p_component), row),
+			p_data);
+}
+
+void ArchetypeTable::remove(EntityID p_entity, godex::component_id p_component) {
+	const uint32_t index = p_entity;
+	if (index >= locations.size() || locations[index].archetype == UINT32_MAX) {
+		// Nothing to do.
+		return;
+	}
+
+	const uint32_t from = locations[index].archetype;
+	if (archetypes[from]->get_column(p_component) == -1) {
+		// Nothing to do.
+		return;
+	}
+
+	const uint32_t to = get_transition(from, p_component, false);
+	move_entity(p_entity, to);
+}
+
+void ArchetypeTable::remove_entity(EntityID p_entity) {
+	const uint32_t index = p_entity;
+	if (index >= locations.size() || locations[index].archetype == UINT32_MAX) {
+		// Nothing to do.
+		return;
+	}
+
+	move_entity(p_entity, UINT32_MAX);
+}
+
+void ArchetypeTable::fetch_entities(godex::component_id p_component, LocalVector<EntityID> &r_entities) const {
+	for (uint32_t a = 0; a < archetypes.size(); a += 1) {
+		const Archetype *archetype = archetypes[a];
+		if (archetype->size == 0 || archetype->get_column(p_component) == -1) {
+			continue;
+		}
+		const uint32_t start = r_entities.size();
+		r_entities.resize(start + archetype->size);
+		for (uint32_t c = 0; c < archetype->chunks.size(); c += 1) {
+			const uint32_t chunk_size = archetype->get_chunk_size(c);
+			if (chunk_size == 0) {
+				break;
+			}
+			memcpy(r_entities.ptr() + start + (c << archetype->chunk_shift), archetype->get_chunk_entities(c), sizeof(EntityID) * chunk_size);
+		}
+	}
+}
+
+uint32_t ArchetypeTable::find_or_create_archetype(const LocalVector<godex::component_id> &p_signature) {
+	for (uint32_t a = 0; a < archetypes.size(); a += 1) {
+		const LocalVector<godex::component_id> &signature = archetypes[a]->signature;
+		if (signature.size() != p_signature.size()) {
+			continue;
+		}
+		bool same = true;
+		for (uint32_t i = 0; i < signature.size() && same; i += 1) {
+			same = signature[i] == p_signature[i];
+		}
+		if (same) {
+			return a;
+		}
+	}
+
+	// Not found, create it.
+	LocalVector<ArchetypeColumnInfo> columns;
+	columns.resize(p_signature.size());
+	for (uint32_t i = 0; i < p_signature.size(); i += 1) {
+		columns[i] = columns_info[p_signature[i]];
+	}
+
+	Archetype *archetype = memnew(Archetype);
+	archetype->setup(columns, chunk_size);
+	archetypes.push_back(archetype);
+	return archetypes.size() - 1;
+}
+
+uint32_t ArchetypeTable::get_transition(uint32_t p_from, godex::component_id p_component, bool p_add) {
+	if (p_from == UINT32_MAX) {
+		// From no components, it's possible only to add.
+		CRASH_COND(p_add == false);
+		if (single_component_archetypes[p_component] == UINT32_MAX) {
+			LocalVector<godex::component_id> signature;
+			signature.push_back(p_component);
+			single_component_archetypes[p_component] = find_or_create_archetype(signature);
+		}
+		return single_component_archetypes[p_component];
+	}
+
+	// Search the cached transitions first.
+	{
+		const LocalVector<Archetype::Edge> &edges = archetypes[p_from]->edges;
+		for (uint32_t i = 0; i < edges.size(); i += 1) {
+			if (edges[i].component == p_component && edges[i].add == p_add) {
+				return edges[i].archetype;
+			}
+		}
+	}
+
+	// Compute the new signature, keeping it sorted.
+	LocalVector<godex::component_id> signature;
+	const LocalVector<godex::component_id> &from_signature = archetypes[p_from]->signature;
+	signature.reserve(from_signature.size() + 1);
+	bool added = false;
+	for (uint32_t i = 0; i < from_signature.size(); i += 1) {
+		if (p_add && added == false && p_component < from_signature[i]) {
+			signature.push_back(p_component);
+			added = true;
+		}
+		if (p_add == false && from_signature[i] == p_component) {
+			continue;
+		}
+		signature.push_back(from_signature[i]);
+	}
+	if (p_add && added == false) {
+		signature.push_back(p_component);
+	}
+
+	const uint32_t to = signature.size() == 0 ? UINT32_MAX : find_or_create_archetype(signature);
+	archetypes[p_from]->edges.push_back({ p_component, p_add, to });
+	return to;
+}
+
+uint32_t ArchetypeTable::move_entity(EntityID p_entity, uint32_t p_to) {
+	const uint32_t index = p_entity;
+	const Location location = locations[index];
+
+	structure_version += 1;
+
+	uint32_t new_row = 0;
+	Archetype *to = p_to == UINT32_MAX ? nullptr : archetypes[p_to];
+	if (to) {
+		new_row = to->push_row(p_entity);
+	}
+
+	if (location.archetype != UINT32_MAX) {
+		Archetype *from = archetypes[location.archetype];
+		for (uint32_t c = 0; c < from->columns.size(); c += 1) {
+			void *src = from->get_component(c, location.row);
+			if (to) {
+				const int32_t to_column = to->get_column(from->signature[c]);
+				if (to_column != -1) {
+					from->columns[c].copy_construct(to->get_component(to_column, new_row), src);
+				}
+			}
+			from->columns[c].destroy(src);
+		}
+		remove_row(location.archetype, location.row);
+	}
+
+	locations[index].archetype = p_to;
+	locations[index].row = new_row;
+	return new_row;
+}
+
+void ArchetypeTable::remove_row(uint32_t p_archetype, uint32_t p_row) {
+	Archetype *archetype = archetypes[p_archetype];
+	const uint32_t last = archetype->size - 1;
+
+	if (p_row != last) {
+		// Move the last row into the hole.
+		for (uint32_t c = 0; c < archetype->columns.size(); c += 1) {
+			void *src = archetype->get_component(c, last);
+			archetype->columns[c].copy_construct(archetype->get_component(c, p_row), src);
+			archetype->columns[c].destroy(src);
+		}
+		const EntityID moved = archetype->get_entity(last);
+		archetype->get_entity(p_row) = moved;
+		locations[uint32_t(moved)].row = p_row;
+	}
+
+	archetype->size -= 1;
+
+	// Release the last chunk when it's empty.
+	if (archetype->chunks.size() > 0 && (archetype->size >> archetype->chunk_shift) + 1 < archetype->chunks.size()) {
+		memfree(archetype->chunks[archetype->chunks.size() - 1]);
+		archetype->chunks.resize(archetype->chunks.size() - 1);
+	}
+}
@@ -0,0 +1,230 @@
+#pragma once
+
+#include "../ecs_types.h"
+#include "core/templates/local_vector.h"
+
+/// Describes a component type stored inside the `ArchetypeTable`. The table is
+/// type erased, so it relies on these functions to handle the memory.
+struct ArchetypeColumnInfo {
+	godex::component_id id = godex::COMPONENT_NONE;
+	uint32_t size = 0;
+	uint32_t alignment = 1;
+	/// Copy constructs `p_src` into the uninitialized memory `p_dst`.
+	void (*copy_construct)(void *p_dst, const void *p_src) = nullptr;
+	/// Destroys the component, without releasing the memory.
+	void (*destroy)(void *p_data) = nullptr;
+};
+
+/// An `Archetype` stores all the `Entities` that have the exact same set of
+/// components.
+///
+/// The data is stored into fixed size chunks, each chunk contains up to
+/// `chunk_capacity` entities; inside the chunk the data is stored per
+/// component (SoA): first the `EntityID`s, then each component column.
+///
+/// ```
+/// Chunk: | EntityID x capacity | Component A x capacity | Component B x capacity |
+/// ```
+class Archetype {
+	friend class ArchetypeTable;
+
+	/// The components of this archetype, sorted by id.
+	LocalVector<godex::component_id> signature;
+	/// The columns info, in the same order of `signature`.
+	LocalVector<ArchetypeColumnInfo> columns;
+	/// The column offset inside the chunk, in the same order of `signature`.
+	LocalVector<uint32_t> column_offsets;
+	/// Maps the `component_id` to the column index, -1 if not stored.
+	LocalVector<int32_t> component_to_column;
+
+	/// The chunk capacity is always a power of two.
+	uint32_t chunk_shift = 0;
+	uint32_t chunk_mask = 0;
+	uint32_t chunk_memory_size = 0;
+	LocalVector<uint8_t *> chunks;
+
+	/// Amount of `Entities` stored.
+	uint32_t size = 0;
+
+	/// Cached transitions to the other archetypes.
+	struct Edge {
+		godex::component_id component;
+		bool add;
+		uint32_t archetype;
+	};
+	LocalVector<Edge> edges;
+
+public:
+	~Archetype();
+
+	_FORCE_INLINE_ uint32_t get_size() const {
+		return size;
+	}
+
+	_FORCE_INLINE_ uint32_t get_chunk_capacity() const {
+		return chunk_mask + 1;
+	}
+
+	_FORCE_INLINE_ uint32_t get_chunk_count() const {
+		return chunks.size();
+	}
+
+	/// Returns the amount of `Entities` stored inside the chunk.
+	_FORCE_INLINE_ uint32_t get_chunk_size(uint32_t p_chunk) const {
+		const uint32_t begin = p_chunk << chunk_shift;
+		if (begin >= size) {
+			return 0;
+		}
+		return MIN(size - begin, get_chunk_capacity());
+	}
+
+	const LocalVector<godex::component_id> &get_signature() const {
+		return signature;
+	}
+
+	/// Returns the column index of this component, or -1.
+	_FORCE_INLINE_ int32_t get_column(godex::component_id p_component) const {
+		if (p_component < component_to_column.size()) {
+			return component_to_column[p_component];
+		}
+		return -1;
+	}
+
+	_FORCE_INLINE_ const EntityID *get_chunk_entities(uint32_t p_chunk) const {
+		return reinterpret_cast<const EntityID *>(chunks[p_chunk]);
+	}
+
+	/// Returns the first component of this column, inside the chunk.
+	_FORCE_INLINE_ void *get_chunk_column(uint32_t p_chunk, uint32_t p_column) {
+		return chunks[p_chunk] + column_offsets[p_column];
+	}
+
+	_FORCE_INLINE_ const void *get_chunk_column(uint32_t p_chunk, uint32_t p_column) const {
+		return chunks[p_chunk] + column_offsets[p_column];
+	}
+
+	_FORCE_INLINE_ void *get_component(uint32_t p_column, uint32_t p_row) {
+		return chunks[p_row >> chunk_shift] + column_offsets[p_column] + ((p_row & chunk_mask) * columns[p_column].size);
+	}
+
+	_FORCE_INLINE_ const void *get_component(uint32_t p_column, uint32_t p_row) const {
+		return chunks[p_row >> chunk_shift] + column_offsets[p_column] + ((p_row & chunk_mask) * columns[p_column].size);
+	}
+
+	_FORCE_INLINE_ EntityID &get_entity(uint32_t p_row) {
+		return reinterpret_cast<EntityID *>(chunks[p_row >> chunk_shift])[p_row & chunk_mask];
+	}
+
+private:
+	void setup(const LocalVector<ArchetypeColumnInfo> &p_columns, uint32_t p_chunk_size);
+
+	/// Adds a new row at the end, for this `Entity`, and returns its index.
+	/// The components memory is not initialized.
+	uint32_t push_row(EntityID p_entity);
+};
+
+/// The `ArchetypeTable` stores the components of all the `ArchetypeStorage`s of
+/// a `World`. Each `Entity` lives in exactly one `Archetype`: when a component
+/// is added or removed, the `Entity` is moved to the archetype that matches its
+/// new set of components.
+///
+/// Since the components of an `Entity` are stored next to each other, and all
+/// the entities of an archetype are packed together, iterating many components
+/// of the same entities streams the memory linearly.
+class ArchetypeTable {
+	struct Location {
+		uint32_t archetype = UINT32_MAX;
+		uint32_t row = 0;
+	};
+
+	/// Target chunk size in bytes.
+	uint32_t chunk_size = 16 * 1024;
+
+	LocalVector<Archetype *> archetypes;
+	/// Location of each `Entity`, indexed by `EntityID`.
+	LocalVector<Location> locations;
+	/// The registered columns info, indexed by `component_id`.
+	LocalVector<ArchetypeColumnInfo> columns_info;
+	/// The archetypes containing only one component, indexed by `component_id`.
+	LocalVector<uint32_t> single_component_archetypes;
+
+	/// Incremented each time an `Entity` is moved, added or removed.
+	uint64_t structure_version = 0;
+
+public:
+	~ArchetypeTable();
+
+	/// Set the chunk size in bytes, it's used only by the archetypes
+	/// created after this call.
+	void set_chunk_size(uint32_t p_chunk_size);
+
+	void register_column(const ArchetypeColumnInfo &p_info);
+
+	_FORCE_INLINE_ bool has(EntityID p_entity, godex::component_id p_component) const {
+		const uint32_t index = p_entity;
+		if (index >= locations.size() || locations[index].archetype == UINT32_MAX) {
+			return false;
+		}
+		return archetypes[locations[index].archetype]->get_column(p_component) != -1;
+	}
+
+	/// Returns the component, or `nullptr`.
+	_FORCE_INLINE_ void *get(EntityID p_entity, godex::component_id p_component) {
+		return const_cast<void *>(const_cast<const ArchetypeTable *>(this)->get(p_entity, p_component));
+	}
+
+	_FORCE_INLINE_ const void *get(EntityID p_entity, godex::component_id p_component) const {
+		const uint32_t index = p_entity;
+		if (unlikely(index >= locations.size() || locations[index].archetype == UINT32_MAX)) {
+			return nullptr;
+		}
+		const Location &location = locations[index];
+		const Archetype *archetype = archetypes[location.archetype];
+		const int32_t column = archetype->get_column(p_component);
+		if (unlikely(column == -1)) {
+			return nullptr;
+		}
+		return archetype->get_component(column, location.row);
+	}
+
+	/// Adds the component to the `Entity`, or replaces the stored one.
+	void insert(EntityID p_entity, godex::component_id p_component, const void *p_data);
+
+	/// Removes the component from the `Entity`, if any.
+	void remove(EntityID p_entity, godex::component_id p_component);
+
+	/// Removes all the components of this `Entity` at once.
+	void remove_entity(EntityID p_entity);
+
+	/// Appends to `r_entities` all the `Entities` that have this component,
+	/// in memory order.
+	void fetch_entities(godex::component_id p_component, LocalVector<EntityID> &r_entities) const;
+
+	uint64_t get_structure_version() const {
+		return structure_version;
+	}
+
+	uint32_t get_archetype_count() const {
+		return archetypes.size();
+	}
+
+	Archetype *get_archetype(uint32_t p_index) {
+		return archetypes[p_index];
+	}
+
+	const Archetype *get_archetype(uint32_t p_index) const {
+		return archetypes[p_index];
+	}
+
+private:
+	uint32_t find_or_create_archetype(const LocalVector<godex::component_id> &p_signature);
+	uint32_t get_transition(uint32_t p_from, godex::component_id p_component, bool p_add);
+
+	/// Moves the `Entity` to the archetype `p_to`, the components that don't
+	/// exist in the destination archetype are destroyed.
+	/// Returns the new row.
+	uint32_t move_entity(EntityID p_entity, uint32_t p_to);
+
+	/// Removes the row, the components must be already destroyed.
+	void remove_row(uint32_t p_archetype, uint32_t p_row);
+};
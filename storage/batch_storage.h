@@ -28,10 +28,15 @@ public:
 			StaticVector<T, SIZE> v;
 			v.push_back(p_data);
 			storage.insert(p_entity, v);
+			StorageBase::notify_inserted(p_entity);
 		}
 		StorageBase::notify_changed(p_entity);
 	}
 
+	virtual bool notifies_entity_signature() const override {
+		return true;
+	}
+
 	virtual bool has(EntityID p_entity) const override {
 		return storage.has(p_entity);
 	}
@@ -53,9 +58,11 @@ public:
 		storage.remove(p_entity);
 		// Make sure to remove as changed.
 		StorageBase::notify_updated(p_entity);
+		StorageBase::notify_removed(p_entity);
 	}
 
 	virtual void clear() override {
+		StorageBase::notify_removed_all();
 		storage.clear();
 		StorageBase::flush_changed();
 	}
@@ -85,10 +92,15 @@ public:
 			s.resize(1);
 			s[0] = p_data;
 			storage.insert(p_entity, s);
+			StorageBase::notify_inserted(p_entity);
 		}
 		StorageBase::notify_changed(p_entity);
 	}
 
+	virtual bool notifies_entity_signature() const override {
+		return true;
+	}
+
 	virtual bool has(EntityID p_entity) const override {
 		return storage.has(p_entity);
 	}
@@ -112,9 +124,11 @@ public:
 		storage.remove(p_entity);
 		// Make sure to remove as changed.
 		StorageBase::notify_updated(p_entity);
+		StorageBase::notify_removed(p_entity);
 	}
 
 	virtual void clear() override {
+		StorageBase::notify_removed_all();
 		storage.clear();
 		StorageBase::flush_changed();
 	}
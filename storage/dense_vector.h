@@ -2,6 +2,7 @@
 
 #include "../ecs.h"
 #include "core/templates/local_vector.h"
+#include "paged_sparse_array.h"
 #include "storage.h"
 
 template <class T>
@@ -9,12 +10,19 @@ class DenseVector {
 protected:
 	LocalVector<T> data;
 	LocalVector<EntityID> data_to_entity;
-	// Each position of this vector is an Entity Index.
-	LocalVector<uint32_t> entity_to_data;
+	// Maps each Entity Index to its data index, paged so that a high Entity
+	// index doesn't allocate the whole array.
+	PagedSparseArray entity_to_data;
+	/// The slots before this are sorted by ascending `EntityID` index, see
+	/// `sort_by_entity`.
+	uint32_t sorted_count = 0;
 
 public:
 	void insert(EntityID p_entity, const T &p_data) {
 		const uint32_t index = data.size();
+		if (sorted_count == index && (index == 0 || data_to_entity[index - 1].get_index() < p_entity.get_index())) {
+			sorted_count = index + 1;
+		}
 		insert_entity(p_entity, index);
 
 		// Store the data
@@ -22,57 +30,105 @@ public:
 		data_to_entity.push_back(p_entity);
 	}
 
+	/// Inserts the same data to `p_count` contiguous entities, starting from
+	/// `p_first`: the memory is reserved once.
+	void insert_batch(EntityID p_first, uint32_t p_count, const T &p_data) {
+		if (p_count == 0) {
+			return;
+		}
+
+		const uint32_t start = data.size();
+		if (sorted_count == start && (start == 0 || data_to_entity[start - 1].get_index() < p_first.get_index())) {
+			sorted_count = start + p_count;
+		}
+		data.reserve(start + p_count);
+		data_to_entity.reserve(start + p_count);
+
+		for (uint32_t i = 0; i < p_count; i += 1) {
+			const EntityID entity(p_first.get_index() + i, p_first.get_generation());
+			entity_to_data.set(entity, start + i);
+			data.push_back(p_data);
+			data_to_entity.push_back(entity);
+		}
+	}
+
 	bool has(EntityID p_entity) const {
-		return p_entity < entity_to_data.size() && entity_to_data[p_entity] != UINT32_MAX;
+		return entity_to_data.has(p_entity);
 	}
 
 	const T &get(EntityID p_entity) const {
 #ifdef DEBUG_ENABLED
 		CRASH_COND_MSG(has(p_entity) == false, "This entity doesn't have anything stored into this storage.");
 #endif
-		return data[entity_to_data[p_entity]];
+		return data[entity_to_data.get(p_entity)];
 	}
 
 	T &get(EntityID p_entity) {
 #ifdef DEBUG_ENABLED
 		CRASH_COND_MSG(has(p_entity) == false, "This entity doesn't have anything stored into this storage.");
 #endif
-		return data[entity_to_data[p_entity]];
+		return data[entity_to_data.get(p_entity)];
 	}
 
 	void remove(EntityID p_entity) {
 		ERR_FAIL_COND_MSG(has(p_entity) == false, "This entity doesn't have anything stored into this storage.");
 
 		const uint32_t last = data.size() - 1;
+		const uint32_t index = entity_to_data.get(p_entity);
 
-		if (entity_to_data[p_entity] != last) {
+		// The last element moves into the hole.
+		sorted_count = MIN(sorted_count, index);
+
+		if (index != last) {
 			// This entity is the last one, so swap the alst with the current one
 			// to remove.
-
 			// Copy the last array element on the data element to remove.
-			data[entity_to_data[p_entity]] = data[last];
+			data[index] = data[last];
 
 			// Make sure the entity for the last array element, points to the right slot.
-			entity_to_data[data_to_entity[last]] = entity_to_data[p_entity];
+			entity_to_data.set(data_to_entity[last], index);
 
 			// Now updated the data to entity by simply coping what's in the last.
-			data_to_entity[entity_to_data[p_entity]] = data_to_entity[last];
+			data_to_entity[index] = data_to_entity[last];
 		}
 
 		data.remove(last);
 		data_to_entity.remove(last);
-		entity_to_data[p_entity] = UINT32_MAX;
+		entity_to_data.unset(p_entity);
+	}
+
+	/// Returns the slot of this `Entity` into the dense array.
+	uint32_t get_index(EntityID p_entity) const {
+		return entity_to_data.get(p_entity);
+	}
+
+	/// Swaps the data (and the `Entities`) of two slots.
+	void swap_slots(uint32_t p_a, uint32_t p_b) {
+		SWAP(data[p_a], data[p_b]);
+		SWAP(data_to_entity[p_a], data_to_entity[p_b]);
+		entity_to_data.set(data_to_entity[p_a], p_a);
+		entity_to_data.set(data_to_entity[p_b], p_b);
+		sorted_count = MIN(sorted_count, MIN(p_a, p_b));
 	}
 
 	const LocalVector<EntityID> &get_entities() const {
 		return data_to_entity;
 	}
 
+	/// Returns the data, sorted as `get_entities`.
+	T *get_data_ptr() {
+		return data.ptr();
+	}
+
 	/// Clear the storage.
 	void clear() {
+		// Unset only the stored entities, the pages are kept.
+		for (uint32_t i = 0; i < data_to_entity.size(); i += 1) {
+			entity_to_data.unset(data_to_entity[i]);
+		}
 		data.clear();
 		data_to_entity.clear();
-		entity_to_data.clear();
+		sorted_count = 0;
 	}
 
 	/// Reset the storage unallocating the memory.
@@ -80,6 +136,43 @@ public:
 		data.reset();
 		data_to_entity.reset();
 		entity_to_data.reset();
+		sorted_count = 0;
+	}
+
+	bool is_sorted() const {
+		return sorted_count >= data.size();
+	}
+
+	/// Sorts the data by ascending `EntityID` index: the removals swap the last
+	/// element into the hole, so over time the order becomes random. Once
+	/// sorted, the storages of the `Entities` created together are iterated in
+	/// lockstep.
+	///
+	/// The sort is incremental: it's an insertion sort, in place, that stops
+	/// after `p_max_swaps` swaps and continues from there on the next call.
+	/// A removal costs about a swap per element after the hole. Returns the
+	/// amount of swaps done.
+	uint32_t sort_by_entity(uint32_t p_max_swaps) {
+		uint32_t swaps = 0;
+		while (sorted_count < data.size()) {
+			// Move the first unsorted element back, into the sorted slots.
+			uint32_t slot = sorted_count;
+			while (slot > 0 && data_to_entity[slot - 1].get_index() > data_to_entity[slot].get_index()) {
+				if (swaps >= p_max_swaps) {
+					// The slots before this one are still sorted.
+					sorted_count = slot;
+					return swaps;
+				}
+				SWAP(data[slot - 1], data[slot]);
+				SWAP(data_to_entity[slot - 1], data_to_entity[slot]);
+				entity_to_data.set(data_to_entity[slot], slot);
+				slot -= 1;
+				swaps += 1;
+			}
+			entity_to_data.set(data_to_entity[slot], slot);
+			sorted_count += 1;
+		}
+		return swaps;
 	}
 
 	/// Preallocate a given size, avoid useless allocations.
@@ -91,25 +184,11 @@ public:
 		data.reserve(p_reserve);
 		data_to_entity.reserve(p_reserve);
 		entity_to_data.reserve(p_reserve);
-
-		entity_to_data.resize(p_reserve);
-		for (uint32_t i = 0; i < p_reserve; i += 1) {
-			entity_to_data[i] = UINT32_MAX;
-		}
 	}
 
 protected:
 	void insert_entity(EntityID p_entity, uint32_t p_index) {
-		if (entity_to_data.size() <= p_entity) {
-			const uint32_t start = entity_to_data.size();
-			// Resize the vector so to fit this new entity.
-			entity_to_data.resize(p_entity + 1);
-			for (uint32_t i = start; i < entity_to_data.size(); i += 1) {
-				entity_to_data[i] = UINT32_MAX;
-			}
-		}
-
-		// Store the data-index
-		entity_to_data[p_entity] = p_index;
+		// Store the data-index, the page is allocated if needed.
+		entity_to_data.set(p_entity, p_index);
 	}
 };
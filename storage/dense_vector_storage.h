@@ -3,13 +3,15 @@
 #include "../ecs.h"
 #include "dense_vector.h"
 #include "storage.h"
+#include "storage_group.h"
 
 /// Dense vector storage.
 /// Has a redirection 2-way table between entities and
 /// components (vice versa), allowing to leave no gaps within the data.
 /// The the entity indices are stored sparsely.
+/// It can be owned by a `StorageGroup`, through the `group` config.
 template <class T>
-class DenseVectorStorage : public Storage<T> {
+class DenseVectorStorage : public Storage<T>, public GroupStorageBase {
 protected:
 	DenseVector<T> storage;
 
@@ -23,9 +25,40 @@ public:
 		return "DenseVector[" + String(typeid(T).name()) + "]";
 	}
 
+	virtual bool notifies_entity_signature() const override {
+		return true;
+	}
+
 	virtual void insert(EntityID p_entity, const T &p_data) override {
 		storage.insert(p_entity, p_data);
 		StorageBase::notify_changed(p_entity);
+		StorageBase::notify_inserted(p_entity);
+		if (group) {
+			group->on_insert(p_entity);
+		}
+	}
+
+	virtual void insert_batch(EntityID p_first, uint32_t p_count, const T &p_data) override {
+		storage.insert_batch(p_first, p_count, p_data);
+		for (uint32_t i = 0; i < p_count; i += 1) {
+			const EntityID entity(p_first.get_index() + i, p_first.get_generation());
+			StorageBase::notify_changed(entity);
+			StorageBase::notify_inserted(entity);
+			if (group) {
+				group->on_insert(entity);
+			}
+		}
+	}
+
+	virtual void insert_list(const EntityID *p_entities, const T *p_data, uint32_t p_count) override {
+		for (uint32_t i = 0; i < p_count; i += 1) {
+			storage.insert(p_entities[i], p_data[i]);
+			StorageBase::notify_changed(p_entities[i]);
+			StorageBase::notify_inserted(p_entities[i]);
+			if (group) {
+				group->on_insert(p_entities[i]);
+			}
+		}
 	}
 
 	virtual bool has(EntityID p_entity) const override {
@@ -42,19 +75,58 @@ public:
 	}
 
 	virtual void remove(EntityID p_entity) override {
+		if (group && storage.has(p_entity)) {
+			// Move it out of the group first, so the removal doesn't break
+			// the partition.
+			group->on_remove(p_entity);
+		}
 		storage.remove(p_entity);
 		// Make sure to remove as changed.
 		StorageBase::notify_updated(p_entity);
+		StorageBase::notify_removed(p_entity);
 	}
 
 	virtual void clear() override {
+		StorageBase::notify_removed_all();
 		storage.clear();
+		if (group) {
+			group->on_clear();
+		}
 		StorageBase::flush_changed();
 	}
 
 	virtual EntitiesBuffer get_stored_entities() const {
 		return { storage.get_entities().size(), storage.get_entities().ptr() };
 	}
+
+	virtual void *get_dense_data() override {
+		return storage.get_data_ptr();
+	}
+
+	virtual bool needs_sort() const override {
+		// The group decides the order.
+		return group == nullptr && storage.is_sorted() == false;
+	}
+
+	virtual uint32_t sort_by_entity(uint32_t p_max_swaps) override {
+		return storage.sort_by_entity(p_max_swaps);
+	}
+
+	virtual bool group_has(EntityID p_entity) const override {
+		return storage.has(p_entity);
+	}
+
+	virtual uint32_t get_group_slot(EntityID p_entity) const override {
+		return storage.get_index(p_entity);
+	}
+
+	virtual void swap_group_slots(uint32_t p_a, uint32_t p_b) override {
+		storage.swap_slots(p_a, p_b);
+	}
+
+	virtual EntitiesBuffer get_group_entities() const override {
+		return get_stored_entities();
+	}
 };
 
 template <class T>
@@ -1,6 +1,7 @@
 #pragma once
 
 #include "../ecs_types.h"
+#include "paged_sparse_array.h"
 
 /// Container used to mark the `Entity` as changed.
 /// To mark an `Entity` as changed you can use `notify_updated`.
@@ -11,7 +12,7 @@
 class EntityList {
 	/// Sparse vector, used to easily know if an entity changed.
 	/// points to the dense_list element.
-	LocalVector<uint32_t> entity_to_data;
+	PagedSparseArray entity_to_data;
 
 	/// Used to iterate fast.
 	LocalVector<EntityID> dense_list;
@@ -47,7 +48,7 @@ public:
 	uint32_t size() const;
 
 	/// Clear the memory, but don't deallocate it so next frame it will run
-	/// faster.
+	/// faster. The cost is proportional to `size()`.
 	void clear();
 
 	/// Release the memory completely.
@@ -0,0 +1,61 @@
+#include "entity_signatures.h"
+
+#include "core/os/memory.h"
+
+EntitySignatures::~EntitySignatures() {
+	if (pages == nullptr) {
+		return;
+	}
+	for (uint32_t i = 0; i < PAGE_COUNT; i += 1) {
+		Word *page = pages[i].load(std::memory_order_relaxed);
+		if (page != nullptr) {
+			memdelete_arr(page);
+		}
+	}
+	memdelete_arr(pages);
+}
+
+void EntitySignatures::setup(uint32_t p_components_count) {
+	CRASH_COND_MSG(pages != nullptr, "The `EntitySignatures` is already set up.");
+	words = MAX(1u, (p_components_count + 63) / 64);
+	pages = memnew_arr(std::atomic<Word *>, PAGE_COUNT);
+	for (uint32_t i = 0; i < PAGE_COUNT; i += 1) {
+		pages[i].store(nullptr, std::memory_order_relaxed);
+	}
+}
+
+bool EntitySignatures::has(EntityID p_entity, godex::component_id p_component) const {
+	if (can_track(p_component) == false) {
+		return false;
+	}
+	const Word *signature = const_cast<EntitySignatures *>(this)->get_signature(p_entity, false);
+	if (signature == nullptr) {
+		return false;
+	}
+	return signature[p_component >> 6].load(std::memory_order_relaxed) & (uint64_t(1) << (p_component & 63));
+}
+
+void EntitySignatures::clear(EntityID p_entity) {
+	Word *signature = get_signature(p_entity, false);
+	if (signature == nullptr) {
+		return;
+	}
+	for (uint32_t w = 0; w < words; w += 1) {
+		signature[w].store(0, std::memory_order_relaxed);
+	}
+}
+
+EntitySignatures::Word *EntitySignatures::create_page(uint32_t p_page) {
+	Word *page = memnew_arr(Word, PAGE_SIZE * words);
+	for (uint32_t i = 0; i < PAGE_SIZE * words; i += 1) {
+		page[i].store(0, std::memory_order_relaxed);
+	}
+
+	// Another thread may be creating the same page: only one wins.
+	Word *expected = nullptr;
+	if (pages[p_page].compare_exchange_strong(expected, page, std::memory_order_acq_rel) == false) {
+		memdelete_arr(page);
+		return expected;
+	}
+	return page;
+}
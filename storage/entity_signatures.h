@@ -0,0 +1,85 @@
+#pragma once
+
+#include "../ecs_types.h"
+#include <atomic>
+
+/// Keeps track of the components of each `Entity`, using a bitset per
+/// `Entity`: the bit `N` is set when the `Entity` has the component `N`.
+///
+/// The storages set and unset the bits while they are used by the `System`s,
+/// that may run in parallel, so the bits are updated atomically. The memory is
+/// paged and the pages are never moved, so a page can be created by a thread
+/// while the other threads are using the others.
+class EntitySignatures {
+	static constexpr uint32_t PAGE_SHIFT = 12;
+	static constexpr uint32_t PAGE_SIZE = 1 << PAGE_SHIFT;
+	static constexpr uint32_t PAGE_MASK = PAGE_SIZE - 1;
+	static constexpr uint32_t PAGE_COUNT = (EntityID::INDEX_MASK >> PAGE_SHIFT) + 1;
+
+	typedef std::atomic<uint64_t> Word;
+
+	/// The amount of words used by each `Entity`.
+	uint32_t words = 1;
+	std::atomic<Word *> *pages = nullptr;
+
+public:
+	~EntitySignatures();
+
+	/// Prepares the signatures to track `p_components_count` components: it
+	/// must be called before using it.
+	void setup(uint32_t p_components_count);
+
+	/// Returns `true` if this component can be tracked.
+	bool can_track(godex::component_id p_component) const {
+		return p_component < (words * 64);
+	}
+
+	_FORCE_INLINE_ void insert(EntityID p_entity, godex::component_id p_component) {
+		Word *signature = get_signature(p_entity, true);
+		signature[p_component >> 6].fetch_or(uint64_t(1) << (p_component & 63), std::memory_order_relaxed);
+	}
+
+	_FORCE_INLINE_ void remove(EntityID p_entity, godex::component_id p_component) {
+		Word *signature = get_signature(p_entity, false);
+		if (signature != nullptr) {
+			signature[p_component >> 6].fetch_and(~(uint64_t(1) << (p_component & 63)), std::memory_order_relaxed);
+		}
+	}
+
+	bool has(EntityID p_entity, godex::component_id p_component) const;
+
+	/// Unsets all the bits of this `Entity`.
+	void clear(EntityID p_entity);
+
+	/// Calls `p_func` for each component of this `Entity`.
+	template <typename F>
+	void for_each(EntityID p_entity, F p_func) const {
+		const Word *signature = const_cast<EntitySignatures *>(this)->get_signature(p_entity, false);
+		if (signature == nullptr) {
+			return;
+		}
+		for (uint32_t w = 0; w < words; w += 1) {
+			uint64_t word = signature[w].load(std::memory_order_relaxed);
+			for (godex::component_id component = w * 64; word != 0; component += 1, word >>= 1) {
+				if (word & 1) {
+					p_func(component);
+				}
+			}
+		}
+	}
+
+private:
+	Word *get_signature(EntityID p_entity, bool p_create) {
+		const uint32_t index = p_entity;
+		Word *page = pages[index >> PAGE_SHIFT].load(std::memory_order_acquire);
+		if (unlikely(page == nullptr)) {
+			if (p_create == false) {
+				return nullptr;
+			}
+			page = create_page(index >> PAGE_SHIFT);
+		}
+		return page + ((index & PAGE_MASK) * words);
+	}
+
+	Word *create_page(uint32_t p_page);
+};
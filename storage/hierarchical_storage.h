@@ -1,26 +1,89 @@
 #pragma once
 
 #include "../components/child.h"
+#include "../pipeline/thread_pool.h"
 #include "dense_vector.h"
+#include "paged_sparse_array.h"
+#include <atomic>
+#include <cstring>
 
 class Hierarchy;
 
 class HierarchicalStorageBase {
 	friend class Hierarchy;
 
+public:
+	/// How the changes are propagated to the children, set through the
+	/// `propagation` storage config.
+	enum Propagation {
+		/// Each changed `Entity` updates its children recursively.
+		PROPAGATION_RECURSIVE,
+		/// The components are kept sorted by depth (parents before children),
+		/// so a single linear pass over the dense array updates all the
+		/// changed subtrees, without recursion. Convenient for big and deep
+		/// hierarchies, where many `Entities` change each frame.
+		PROPAGATION_DEPTH_SORTED,
+	};
+
 protected:
 	const Hierarchy *hierarchy = nullptr;
+	Propagation propagation = PROPAGATION_RECURSIVE;
+	/// When `true`, the `PROPAGATION_RECURSIVE` flush processes the
+	/// independent dirty subtrees on the `ThreadPool`.
+	bool parallel_flush = false;
+	/// When `true`, the changes are not propagated when a `System` releases
+	/// the storage, but before the next stage that takes it.
+	bool lazy_global = false;
 
 public:
 	virtual ~HierarchicalStorageBase() {}
 	virtual void flush_hierarchy_changes() = 0;
+
+	void set_propagation(Propagation p_propagation) {
+		propagation = p_propagation;
+	}
+
+	Propagation get_propagation() const {
+		return propagation;
+	}
+
+	void set_parallel_flush(bool p_parallel) {
+		parallel_flush = p_parallel;
+	}
+
+	bool is_parallel_flush() const {
+		return parallel_flush;
+	}
+
+	void set_lazy_global(bool p_lazy) {
+		lazy_global = p_lazy;
+	}
+
+	bool is_lazy_global() const {
+		return lazy_global;
+	}
 };
 
+/// Stores the parenting of the `Entities`. The children of each `Entity` are
+/// stored contiguously into a single pool (see `Child::children_offset`), so
+/// iterating them is a linear scan, and adding or removing a child is O(1)
+/// amortised: a range that is full moves at the end of the pool, and the pool
+/// is compacted when most of it is unused.
 class Hierarchy : public Storage<Child> {
 	DenseVector<Child> storage;
+	/// The children of all the `Entities`.
+	LocalVector<EntityID> children_pool;
+	/// The slots of `children_pool` that no range uses anymore.
+	uint32_t children_pool_unused = 0;
 	EntityList hierarchy_changed;
 	LocalVector<HierarchicalStorageBase *> sub_storages;
 
+	/// Incremented each time the structure changes.
+	uint64_t version = 0;
+	/// The `Entities` sorted by depth, built on demand by `get_depth_order`.
+	mutable LocalVector<EntityID> depth_order;
+	mutable uint64_t depth_order_version = UINT64_MAX;
+
 public:
 	void configure(const Dictionary &p_config) {
 		storage.reset();
@@ -37,6 +100,37 @@ public:
 		return hierarchy_changed;
 	}
 
+	/// Returns a number that changes each time the structure changes.
+	uint64_t get_version() const {
+		return version;
+	}
+
+	/// Returns all the `Entities` of the hierarchy, sorted by depth: the
+	/// parents always come before their children.
+	/// The order is cached into the `Hierarchy`, so it's not thread safe: the
+	/// storages call it only when they flush, on the main thread.
+	const LocalVector<EntityID> &get_depth_order() const {
+		if (depth_order_version == version) {
+			return depth_order;
+		}
+		depth_order.clear();
+		const LocalVector<EntityID> &entities = storage.get_entities();
+		for (uint32_t i = 0; i < entities.size(); i += 1) {
+			if (storage.get(entities[i]).parent.is_null()) {
+				depth_order.push_back(entities[i]);
+			}
+		}
+		// Breadth first: append the children of each `Entity`.
+		for (uint32_t i = 0; i < depth_order.size(); i += 1) {
+			for_each_child(depth_order[i], [&](EntityID p_child, const Child &p_child_data) -> bool {
+				depth_order.push_back(p_child);
+				return true;
+			});
+		}
+		depth_order_version = version;
+		return depth_order;
+	}
+
 	virtual void on_system_release() override {
 		flush_hierarchy_changes();
 	}
@@ -56,90 +150,91 @@ public:
 		return true;
 	}
 
+	virtual bool notifies_entity_signature() const override {
+		return true;
+	}
+
 	virtual bool has(EntityID p_entity) const override {
 		return storage.has(p_entity);
 	}
 
 	virtual void remove(EntityID p_entity) override {
-		if (storage.has(p_entity)) {
-			Child &child = storage.get(p_entity);
+		if (storage.has(p_entity) == false) {
+			return;
+		}
 
-			// 1. Unlink from parent.
-			unlink_parent(p_entity, child);
+		// 1. Unlink from parent.
+		unlink_parent(p_entity);
 
-			// 2. Unlink the childs.
-			unlink_childs(child);
+		// 2. Unlink the childs.
+		unlink_childs(p_entity);
 
-			// 3. Drop the data.
-			storage.remove(p_entity);
+		// 3. Drop the data.
+		children_pool_unused += storage.get(p_entity).children_capacity;
+		storage.remove(p_entity);
+		StorageBase::notify_removed(p_entity);
 
-			// 4. Mark this as changed.
-			hierarchy_changed.insert(p_entity);
-		}
+		// 4. Mark this as changed.
+		hierarchy_changed.insert(p_entity);
+		version += 1;
 	}
 
 	virtual void clear() override {
+		StorageBase::notify_removed_all();
 		storage.clear();
+		children_pool.clear();
+		children_pool_unused = 0;
+		version += 1;
 	}
 
 	virtual void insert(EntityID p_entity, const Child &p_data) override {
-		bool update;
+		const EntityID parent = p_data.parent;
 
 		if (storage.has(p_entity)) {
 			// This is an update.
-			update = true;
-		} else if (p_data.parent.is_null() == false) {
-			// This is a new insert.
-			update = false;
-			storage.insert(p_entity, p_data);
-		} else {
-			// This is a new insert but there is no parent so nothing to do.
-			return;
-		}
-
-		Child &child = storage.get(p_entity);
-
-		if (update) {
-			if (child.parent == p_data.parent) {
+			if (storage.get(p_entity).parent == parent) {
 				// Same parent, nothing to do.
 				return;
 			}
 
 			// Has another parent, update the relationships:
 			// 1. Unlink p_entity with its current parent.
-			unlink_parent(p_entity, child);
+			unlink_parent(p_entity);
 
 			// 2. Set `p_entity` with its new parent.
-			child.parent = p_data.parent;
+			Child &child = storage.get(p_entity);
+			child.parent = parent;
 
-			if (child.parent.is_null() && child.first_child.is_null()) {
+			if (child.parent.is_null() && child.children_count == 0) {
 				// There are no more relations, so just remove this.
 				remove(p_entity);
 				return;
 			}
+		} else if (parent.is_null() == false) {
+			// This is a new insert: only the parent is taken, the `Hierarchy`
+			// sets the rest.
+			Child child;
+			child.parent = parent;
+			storage.insert(p_entity, child);
+			StorageBase::notify_inserted(p_entity);
 		} else {
-			// This is a new insert, so make sure `first_child` and `next` are
-			// not set.
-			child.first_child = EntityID();
-			child.next = EntityID();
+			// This is a new insert but there is no parent so nothing to do.
+			return;
 		}
 
 		hierarchy_changed.insert(p_entity);
+		version += 1;
 
 		// Update the parent if any.
-		if (child.parent.is_null() == false) {
-			if (has(child.parent) == false) {
+		if (parent.is_null() == false) {
+			if (has(parent) == false) {
 				// Parent is always root when added in this way.
-				storage.insert(child.parent, Child());
-				hierarchy_changed.insert(child.parent);
+				storage.insert(parent, Child());
+				StorageBase::notify_inserted(parent);
+				hierarchy_changed.insert(parent);
 			}
 
-			Child &parent = storage.get(child.parent);
-
-			// Add `child` as child of this parent but keep the chain.
-			EntityID prev_first_child = parent.first_child;
-			parent.first_child = p_entity;
-			child.next = prev_first_child;
+			add_child(parent, p_entity);
 		}
 	}
 
@@ -156,6 +251,12 @@ public:
 		return { storage.get_entities().size(), storage.get_entities().ptr() };
 	}
 
+	/// Returns the children of this `Entity`: they are `p_data.children_count`
+	/// and stored contiguously.
+	const EntityID *get_children(const Child &p_data) const {
+		return children_pool.ptr() + p_data.children_offset;
+	}
+
 	/// For each child, slow version.
 	template <typename F>
 	void for_each_child(EntityID p_entity, F func) const {
@@ -166,14 +267,12 @@ public:
 	/// Iterate over the childs of this `Entity`.
 	template <typename F>
 	void for_each_child(const Child &this_entity_data, F func) const {
-		EntityID next = this_entity_data.first_child;
-		while (next.is_null() == false) {
-			const Child &next_c = storage.get(next);
-			if (func(next, next_c) == false) {
+		const EntityID *children = get_children(this_entity_data);
+		for (uint32_t i = 0; i < this_entity_data.children_count; i += 1) {
+			if (func(children[i], storage.get(children[i])) == false) {
 				// Stop here.
 				return;
 			}
-			next = next_c.next;
 		}
 	}
 
@@ -201,67 +300,113 @@ public:
 private:
 	/// This is private because it's possible to alter the hierarchy only via:
 	/// `insert`, `remove`.
-	template <typename F>
-	void for_each_child_mutable(Child &this_entity_data, F func) {
-		EntityID next = this_entity_data.first_child;
-		while (next.is_null() == false) {
-			Child &next_c = storage.get(next);
-			if (func(next, next_c) == false) {
-				// Stop here.
-				return;
-			}
-			next = next_c.next;
+	void add_child(EntityID p_parent, EntityID p_child) {
+		Child &parent = storage.get(p_parent);
+		if (parent.children_count == parent.children_capacity) {
+			grow_children(parent);
 		}
+		children_pool[parent.children_offset + parent.children_count] = p_child;
+		storage.get(p_child).child_index = parent.children_count;
+		parent.children_count += 1;
 	}
 
-	/// Unlink from parent.
-	void unlink_parent(EntityID p_entity, Child &this_entity_data) {
-		if (this_entity_data.parent.is_null()) {
-			return;
+	/// Removes the child in O(1), moving the last child in its place.
+	void remove_child(EntityID p_parent, EntityID p_child) {
+		Child &parent = storage.get(p_parent);
+		const uint32_t index = storage.get(p_child).child_index;
+#ifdef DEBUG_ENABLED
+		CRASH_COND_MSG(index >= parent.children_count || (children_pool[parent.children_offset + index] == p_child) == false, "The hierarchy is corrupted.");
+#endif
+		const uint32_t last = parent.children_count - 1;
+		if (index != last) {
+			const EntityID moved = children_pool[parent.children_offset + last];
+			children_pool[parent.children_offset + index] = moved;
+			storage.get(moved).child_index = index;
 		}
+		parent.children_count = last;
+		storage.get(p_child).child_index = UINT32_MAX;
+	}
 
-		Child &parent = storage.get(this_entity_data.parent);
-		if (parent.first_child == p_entity) {
-			// This `Entity` is the first child of its parent.
-			parent.first_child = this_entity_data.next;
-
+	/// Doubles the range of the children of this `Entity`: the range is
+	/// extended when it's at the end of the pool, otherwise moved there.
+	void grow_children(Child &p_data) {
+		const uint32_t capacity = MAX(uint32_t(4), p_data.children_capacity * 2);
+		if (p_data.children_capacity > 0 && p_data.children_offset + p_data.children_capacity == children_pool.size()) {
+			children_pool.resize(p_data.children_offset + capacity);
 		} else {
-			// This `Entity` is not the first child, so search it and remove.
-			for_each_child_mutable(parent, [&](EntityID p_sub_child_id, Child &p_sub_child) -> bool {
-				if (p_sub_child.next == p_entity) {
-					// This `Entity` is pointeed by this `sub_child` so remove it.
-					p_sub_child.next = this_entity_data.next;
-					return false;
-				}
-				return true;
-			});
+			if (children_pool_unused > 1024 && children_pool_unused > children_pool.size() / 2) {
+				compact_children_pool();
+			}
+			const uint32_t offset = children_pool.size();
+			children_pool.resize(offset + capacity);
+			for (uint32_t i = 0; i < p_data.children_count; i += 1) {
+				children_pool[offset + i] = children_pool[p_data.children_offset + i];
+			}
+			children_pool_unused += p_data.children_capacity;
+			p_data.children_offset = offset;
+		}
+		p_data.children_capacity = capacity;
+	}
+
+	/// Drops the unused slots of the `children_pool`.
+	void compact_children_pool() {
+		LocalVector<EntityID> compacted;
+		compacted.reserve(children_pool.size() - children_pool_unused);
+		Child *data = storage.get_data_ptr();
+		for (uint32_t i = 0; i < storage.get_entities().size(); i += 1) {
+			if (data[i].children_capacity == 0) {
+				continue;
+			}
+			const uint32_t offset = compacted.size();
+			compacted.resize(offset + data[i].children_capacity);
+			for (uint32_t c = 0; c < data[i].children_count; c += 1) {
+				compacted[offset + c] = children_pool[data[i].children_offset + c];
+			}
+			data[i].children_offset = offset;
+		}
+		children_pool = compacted;
+		children_pool_unused = 0;
+	}
+
+	/// Unlink from parent.
+	void unlink_parent(EntityID p_entity) {
+		const EntityID parent_entity = storage.get(p_entity).parent;
+		if (parent_entity.is_null()) {
+			return;
 		}
 
-		const EntityID parent_entity = this_entity_data.parent;
-		this_entity_data.parent = EntityID();
+		remove_child(parent_entity, p_entity);
+		storage.get(p_entity).parent = EntityID();
 
-		if (parent.first_child.is_null() && parent.parent.is_null()) {
+		const Child &parent = storage.get(parent_entity);
+		if (parent.children_count == 0 && parent.parent.is_null()) {
 			// Since this parent has no more relationships, remove it.
 			remove(parent_entity);
 		}
 	}
 
 	/// Unlink from childs.
-	void unlink_childs(Child &this_entity_data) {
-		for_each_child_mutable(this_entity_data, [&](EntityID p_entity, Child &p_child) -> bool {
-			p_child.parent = EntityID();
-
-			if (p_child.first_child.is_null()) {
+	void unlink_childs(EntityID p_entity) {
+		// Removing the children moves the `Child`s in memory, so fetch them
+		// each time. The children range is not altered.
+		const uint32_t count = storage.get(p_entity).children_count;
+		for (uint32_t i = 0; i < count; i += 1) {
+			const EntityID child_entity = children_pool[storage.get(p_entity).children_offset + i];
+			Child &child = storage.get(child_entity);
+			child.parent = EntityID();
+			child.child_index = UINT32_MAX;
+
+			if (child.children_count == 0) {
 				// Since this child has no more relationships, remove it.
-				remove(p_entity);
+				remove(child_entity);
+			} else {
+				// It's now root.
+				hierarchy_changed.insert(child_entity);
 			}
-
-			// Keep iterate.
-			return true;
-		});
+		}
 
 		// No more childs.
-		this_entity_data.first_child = EntityID();
+		storage.get(p_entity).children_count = 0;
 	}
 };
 
@@ -282,10 +427,53 @@ class HierarchicalStorage : public Storage<T>, public HierarchicalStorageBase {
 	// List of `Entities` taken mutably, for which we need to flush.
 	EntityList relationshitp_dirty_list;
 
+	// `PROPAGATION_DEPTH_SORTED`: the first `hierarchy_slots` slots of the
+	// `internal_storage` are the `Entities` of the hierarchy, sorted by depth.
+	uint32_t hierarchy_slots = 0;
+	/// The slot of the parent of each of these slots, `UINT32_MAX` when it
+	/// has no parent with this component.
+	LocalVector<uint32_t> parent_slots;
+	LocalVector<uint8_t> dirty_slots;
+	/// `false` when a component was inserted or removed after the sort.
+	bool depth_sorted = false;
+	uint64_t depth_sorted_version = UINT64_MAX;
+
+	// The dirty `Entities` without a dirty ancestor, each one is the root of
+	// an independent subtree.
+	LocalVector<EntityID> dirty_roots;
+	LocalVector<const Child *> dirty_roots_child;
+	/// If an `Entity` has a dirty ancestor, set while collecting the roots.
+	PagedSparseArray covered_state;
+	LocalVector<EntityID> covered_touched;
+	LocalVector<EntityID> covered_path;
+
+	// `lazy_global`: set when there are changes to propagate.
+	std::atomic<bool> lazy_pending{ false };
+
 public:
+	/// Config:
+	/// - `pre_allocate`: The amount of components to allocate.
+	/// - `propagation`: `"recursive"` (default) or `"depth_sorted"`, see
+	///   `HierarchicalStorageBase::Propagation`.
+	/// - `parallel_flush`: `true` to process the independent subtrees on the
+	///   `ThreadPool`, with the `recursive` propagation.
+	/// - `lazy_global`: `true` to propagate the changes once before the next
+	///   stage that takes the storage, or when `flush_changes` is called;
+	///   instead of each time a `System` releases the storage. Convenient when
+	///   many `System`s write just the local.
 	void configure(const Dictionary &p_config) {
 		internal_storage.reset();
 		internal_storage.configure(p_config.get("pre_allocate", 500));
+		depth_sorted = false;
+		parallel_flush = p_config.get("parallel_flush", false);
+		lazy_global = p_config.get("lazy_global", false);
+		const String mode = p_config.get("propagation", "recursive");
+		if (mode == "depth_sorted") {
+			propagation = PROPAGATION_DEPTH_SORTED;
+		} else {
+			ERR_FAIL_COND_MSG(mode != "recursive", "The propagation `" + mode + "` is unknown, use `recursive` or `depth_sorted`.");
+			propagation = PROPAGATION_RECURSIVE;
+		}
 	}
 
 	virtual String get_type_name() const override {
@@ -296,17 +484,25 @@ public:
 		return true;
 	}
 
+	virtual bool notifies_entity_signature() const override {
+		return true;
+	}
+
 	virtual bool has(EntityID p_entity) const override {
 		return internal_storage.has(p_entity);
 	}
 
 	virtual void remove(EntityID p_index) override {
 		internal_storage.remove(p_index);
+		depth_sorted = false;
 		StorageBase::notify_updated(p_index);
+		StorageBase::notify_removed(p_index);
 	}
 
 	virtual void clear() override {
+		StorageBase::notify_removed_all();
 		internal_storage.clear();
+		depth_sorted = false;
 		StorageBase::flush_changed();
 	}
 
@@ -314,7 +510,9 @@ public:
 		LocalGlobal<T> d;
 		d.local = p_data;
 		internal_storage.insert(p_entity, d);
+		depth_sorted = false;
 		StorageBase::notify_changed(p_entity);
+		StorageBase::notify_inserted(p_entity);
 		propagate_change(
 				p_entity,
 				internal_storage.get(p_entity));
@@ -326,11 +524,22 @@ public:
 	/// Use the const function suppress this logic.
 	/// The data is flushed at the end of each `system`, however you can flush it
 	/// manually via storage, if you need the data immediately back.
+	/// With `lazy_global`, the data is flushed before the next stage that
+	/// takes this storage: the globals fetched before are not updated.
 	virtual T *get(EntityID p_entity, Space p_mode = Space::LOCAL) override {
-		StorageBase::notify_changed(p_entity);
 		LocalGlobal<T> &data = internal_storage.get(p_entity);
+		if (unlikely(StorageBase::is_recording_changes())) {
+			// Fetched concurrently: the `relationshitp_dirty_list` is updated
+			// later by `apply_recorded_change`.
+			StorageBase::record_change(p_entity);
+		} else {
+			StorageBase::notify_changed(p_entity);
+			if (data.has_relationship) {
+				relationshitp_dirty_list.insert(p_entity);
+				lazy_pending.store(lazy_global, std::memory_order_relaxed);
+			}
+		}
 		if (data.has_relationship) {
-			relationshitp_dirty_list.insert(p_entity);
 			data.global_changed = p_mode == Space::GLOBAL;
 		}
 		return data.is_root || p_mode == Space::LOCAL ? &data.local : &data.global;
@@ -345,6 +554,14 @@ public:
 		return { internal_storage.get_entities().size(), internal_storage.get_entities().ptr() };
 	}
 
+	virtual void apply_recorded_change(EntityID p_entity) override {
+		StorageBase::apply_recorded_change(p_entity);
+		if (internal_storage.has(p_entity) && internal_storage.get(p_entity).has_relationship) {
+			relationshitp_dirty_list.insert(p_entity);
+			lazy_pending.store(lazy_global, std::memory_order_relaxed);
+		}
+	}
+
 	void propagate_change(EntityID p_entity) {
 		if (has(p_entity) == false) {
 			relationshitp_dirty_list.remove(p_entity);
@@ -383,13 +600,13 @@ public:
 		} else {
 			if (p_data.global_changed) {
 				// The global got modified.
-				// Take it non mutable so to not trigger the change list.
-				const T *global_parent_data = const_cast<const HierarchicalStorage<T> *>(this)->get(p_child.parent, Space::GLOBAL);
+				// Read it directly so to not trigger the change list.
+				const T *global_parent_data = get_global_unsynced(p_child.parent);
 				T::combine_inverse(p_data.global, *global_parent_data, p_data.local);
 			} else {
 				// The local was modified.
-				// Take it non mutable so to not trigger the change list.
-				const T *global_parent_data = const_cast<const HierarchicalStorage<T> *>(this)->get(p_child.parent, Space::GLOBAL);
+				// Read it directly so to not trigger the change list.
+				const T *global_parent_data = get_global_unsynced(p_child.parent);
 				T::combine(p_data.local, *global_parent_data, p_data.global);
 			}
 			p_data.is_root = false;
@@ -411,22 +628,265 @@ public:
 	}
 
 	virtual void on_system_release() override {
-		flush_changes();
+		if (lazy_global == false) {
+			flush_changes();
+		}
 	}
 
+	/// With `lazy_global`, propagates the pending changes before the stage
+	/// runs: no `System` is running, so the propagation doesn't alter the
+	/// storage while it's fetched or iterated.
+	virtual void on_stage_read() override {
+		if (lazy_global) {
+			sync_lazy_global();
+		}
+	}
+
+	/// Propagates the changes: each dirty subtree is processed once, from its
+	/// topmost dirty `Entity`, so the cost is linear in the amount of
+	/// `Entities` to update, even when a parent and its descendants are all
+	/// dirty.
 	void flush_changes() {
+		if (propagation == PROPAGATION_DEPTH_SORTED) {
+			flush_changes_depth_sorted();
+		} else {
+			flush_changes_recursive();
+		}
+		lazy_pending.store(false, std::memory_order_release);
+	}
+
+	virtual void flush_hierarchy_changes() override {
+		hierarchy->get_changed().for_each([&](EntityID entity) {
+			relationshitp_dirty_list.insert(entity);
+		});
+		if (lazy_global) {
+			if (relationshitp_dirty_list.is_empty() == false) {
+				lazy_pending.store(true, std::memory_order_release);
+			}
+			return;
+		}
+		flush_changes();
+	}
+
+	/// Returns `true` when, with `lazy_global`, some changes are not yet
+	/// propagated.
+	bool is_lazy_pending() const {
+		return lazy_pending.load(std::memory_order_acquire);
+	}
+
+	/// With `lazy_global`, propagates the pending changes. Called by the
+	/// `Pipeline` before the stages that take this storage, so never while a
+	/// `System` runs.
+	void sync_lazy_global() {
+		if (lazy_pending.load(std::memory_order_acquire)) {
+			flush_changes();
+		}
+	}
+
+private:
+	const T *get_global_unsynced(EntityID p_entity) const {
+		const LocalGlobal<T> &data = internal_storage.get(p_entity);
+		return data.is_root ? &data.local : &data.global;
+	}
+
+	enum CoveredState : uint32_t {
+		NOT_COVERED = 0,
+		COVERED = 1,
+	};
+
+	/// Returns `true` when the propagation of a dirty ancestor reaches this
+	/// `Entity`. The answers are cached into `covered_state` for the whole
+	/// path, so checking all the dirty `Entities` touches each ancestor once.
+	bool is_covered(EntityID p_entity) {
+		covered_path.clear();
+		uint32_t state = NOT_COVERED;
+		EntityID current = p_entity;
+		while (true) {
+			covered_path.push_back(current);
+			const EntityID parent = hierarchy->has(current) ? hierarchy->get(current)->parent : EntityID();
+			if (parent.is_null() || internal_storage.has(parent) == false) {
+				// The propagation stops at the `Entities` without this component.
+				break;
+			}
+			if (relationshitp_dirty_list.has(parent)) {
+				state = COVERED;
+				break;
+			}
+			const uint32_t cached = covered_state.get(parent);
+			if (cached != UINT32_MAX) {
+				state = cached;
+				break;
+			}
+			current = parent;
+		}
+		for (uint32_t i = 0; i < covered_path.size(); i += 1) {
+			covered_state.set(covered_path[i], state);
+			covered_touched.push_back(covered_path[i]);
+		}
+		return state == COVERED;
+	}
+
+	/// Fills `dirty_roots` with the dirty `Entities` that have no dirty
+	/// ancestor, and clears the dirty list: their subtrees cover all the
+	/// dirty `Entities`.
+	void collect_dirty_roots() {
+		dirty_roots.clear();
+		dirty_roots_child.clear();
 		relationshitp_dirty_list.for_each([&](EntityID entity) {
-			propagate_change(entity);
+			if (internal_storage.has(entity) == false || is_covered(entity)) {
+				return;
+			}
+			LocalGlobal<T> &data = internal_storage.get(entity);
+			data.is_root = true;
+			if (hierarchy->has(entity) == false) {
+				// This is not parented, nothing to do.
+				data.has_relationship = false;
+				return;
+			}
+			data.has_relationship = true;
+			dirty_roots.push_back(entity);
+			dirty_roots_child.push_back(hierarchy->get(entity));
 		});
+		relationshitp_dirty_list.clear();
+
+		for (uint32_t i = 0; i < covered_touched.size(); i += 1) {
+			covered_state.unset(covered_touched[i]);
+		}
+		covered_touched.clear();
+	}
+
+	/// Like `propagate_change`, without touching the dirty list: so the
+	/// independent subtrees can be processed concurrently, with
+	/// `parallel_flush`.
+	void propagate_subtree(EntityID p_entity, LocalGlobal<T> &p_data, const Child &p_child) {
+		if (p_child.parent.is_null() == false && has(p_child.parent)) {
+			const LocalGlobal<T> &parent = internal_storage.get(p_child.parent);
+			const T &global_parent_data = parent.is_root ? parent.local : parent.global;
+			if (p_data.global_changed) {
+				T::combine_inverse(p_data.global, global_parent_data, p_data.local);
+			} else {
+				T::combine(p_data.local, global_parent_data, p_data.global);
+			}
+			p_data.is_root = false;
+			p_data.global_changed = false;
+		}
+
+		hierarchy->for_each_child(p_child, [&](EntityID p_child_entity, const Child &p_child_data) -> bool {
+			if (has(p_child_entity)) {
+				propagate_subtree(
+						p_child_entity,
+						internal_storage.get(p_child_entity),
+						p_child_data);
+			}
+			return true;
+		});
+	}
+
+	void propagate_dirty_root(uint32_t p_index, void *p_userdata) {
+		const EntityID entity = dirty_roots[p_index];
+		propagate_subtree(entity, internal_storage.get(entity), *dirty_roots_child[p_index]);
+	}
+
+	/// Moves the `Entities` of the hierarchy at the start of the dense array,
+	/// sorted as `Hierarchy::get_depth_order`.
+	void sort_by_depth() {
+		const LocalVector<EntityID> &order = hierarchy->get_depth_order();
+		hierarchy_slots = 0;
+		for (uint32_t i = 0; i < order.size(); i += 1) {
+			if (internal_storage.has(order[i]) == false) {
+				continue;
+			}
+			const uint32_t slot = internal_storage.get_index(order[i]);
+			if (slot != hierarchy_slots) {
+				internal_storage.swap_slots(slot, hierarchy_slots);
+			}
+			hierarchy_slots += 1;
+		}
+
+		LocalGlobal<T> *data = internal_storage.get_data_ptr();
+		const LocalVector<EntityID> &entities = internal_storage.get_entities();
+		parent_slots.resize(hierarchy_slots);
+		for (uint32_t i = 0; i < hierarchy_slots; i += 1) {
+			const EntityID parent = hierarchy->get(entities[i])->parent;
+			parent_slots[i] = parent.is_null() || internal_storage.has(parent) == false ? UINT32_MAX : internal_storage.get_index(parent);
+			data[i].has_relationship = true;
+		}
+
+		depth_sorted = true;
+		depth_sorted_version = hierarchy->get_version();
+	}
+
+	/// Propagates each dirty subtree once, from its topmost dirty `Entity`.
+	void flush_changes_recursive() {
+		if (relationshitp_dirty_list.is_empty()) {
+			return;
+		}
+
+		collect_dirty_roots();
 #ifdef DEBUG_ENABLED
 		CRASH_COND_MSG(relationshitp_dirty_list.is_empty() == false, "At this point the flush list must be empty.");
 #endif
+
+		if (parallel_flush && dirty_roots.size() > 1 && godex::ThreadPool::do_work(dirty_roots.size(), this, &HierarchicalStorage<T>::propagate_dirty_root, (void *)nullptr)) {
+			return;
+		}
+		for (uint32_t i = 0; i < dirty_roots.size(); i += 1) {
+			propagate_dirty_root(i, nullptr);
+		}
 	}
 
-	virtual void flush_hierarchy_changes() override {
-		hierarchy->get_changed().for_each([&](EntityID entity) {
-			relationshitp_dirty_list.insert(entity);
+	/// Updates all the changed subtrees with a single pass over the slots:
+	/// the parents are always updated before their children.
+	void flush_changes_depth_sorted() {
+		if (relationshitp_dirty_list.is_empty()) {
+			return;
+		}
+		if (depth_sorted == false || depth_sorted_version != hierarchy->get_version()) {
+			sort_by_depth();
+		}
+
+		LocalGlobal<T> *data = internal_storage.get_data_ptr();
+		dirty_slots.resize(hierarchy_slots);
+		if (hierarchy_slots > 0) {
+			memset(dirty_slots.ptr(), 0, hierarchy_slots);
+		}
+		relationshitp_dirty_list.for_each([&](EntityID entity) {
+			if (internal_storage.has(entity) == false) {
+				return;
+			}
+			const uint32_t slot = internal_storage.get_index(entity);
+			if (slot < hierarchy_slots) {
+				dirty_slots[slot] = 1;
+			} else {
+				// Not part of the hierarchy anymore.
+				data[slot].is_root = true;
+				data[slot].has_relationship = false;
+			}
 		});
-		flush_changes();
+		relationshitp_dirty_list.clear();
+
+		for (uint32_t i = 0; i < hierarchy_slots; i += 1) {
+			const uint32_t parent = parent_slots[i];
+			if (parent != UINT32_MAX && dirty_slots[parent]) {
+				dirty_slots[i] = 1;
+			}
+			if (dirty_slots[i] == 0) {
+				continue;
+			}
+
+			LocalGlobal<T> &d = data[i];
+			if (parent == UINT32_MAX) {
+				d.is_root = true;
+			} else {
+				const T &global_parent_data = data[parent].is_root ? data[parent].local : data[parent].global;
+				if (d.global_changed) {
+					T::combine_inverse(d.global, global_parent_data, d.local);
+				} else {
+					T::combine(d.local, global_parent_data, d.global);
+				}
+				d.is_root = false;
+				d.global_changed = false;
+			}
+		}
 	}
 };
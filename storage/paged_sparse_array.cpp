@@ -0,0 +1,84 @@
+#include "paged_sparse_array.h"
+
+#include "core/os/memory.h"
+
+// Never written: `set` allocates a new page before writing.
+uint32_t PagedSparseArray::null_page[PAGE_SIZE] = {};
+
+PagedSparseArray::PagedSparseArray(const PagedSparseArray &p_other) {
+	*this = p_other;
+}
+
+PagedSparseArray &PagedSparseArray::operator=(const PagedSparseArray &p_other) {
+	if (this == &p_other) {
+		return *this;
+	}
+	reset();
+	pages.resize(p_other.pages.size());
+	for (uint32_t p = 0; p < pages.size(); p += 1) {
+		if (p_other.pages[p] == null_page) {
+			pages[p] = null_page;
+		} else {
+			pages[p] = memnew_arr(uint32_t, PAGE_SIZE);
+			memcpy(pages[p], p_other.pages[p], sizeof(uint32_t) * PAGE_SIZE);
+		}
+	}
+	return *this;
+}
+
+PagedSparseArray::~PagedSparseArray() {
+	reset();
+}
+
+void PagedSparseArray::reserve(uint32_t p_size) {
+	if (p_size == 0) {
+		return;
+	}
+	const uint32_t last_page = (p_size - 1) >> PAGE_SHIFT;
+	for (uint32_t p = 0; p <= last_page; p += 1) {
+		if (p >= pages.size() || pages[p] == null_page) {
+			create_page(p);
+		}
+	}
+}
+
+void PagedSparseArray::clear() {
+	for (uint32_t p = 0; p < pages.size(); p += 1) {
+		if (pages[p] != null_page) {
+			memset(pages[p], 0, sizeof(uint32_t) * PAGE_SIZE);
+		}
+	}
+}
+
+void PagedSparseArray::reset() {
+	for (uint32_t p = 0; p < pages.size(); p += 1) {
+		if (pages[p] != null_page) {
+			memdelete_arr(pages[p]);
+		}
+	}
+	pages.reset();
+}
+
+uint32_t PagedSparseArray::get_allocated_page_count() const {
+	uint32_t count = 0;
+	for (uint32_t p = 0; p < pages.size(); p += 1) {
+		if (pages[p] != null_page) {
+			count += 1;
+		}
+	}
+	return count;
+}
+
+void PagedSparseArray::create_page(uint32_t p_page) {
+	if (p_page >= pages.size()) {
+		const uint32_t start = pages.size();
+		pages.resize(p_page + 1);
+		for (uint32_t p = start; p < pages.size(); p += 1) {
+			pages[p] = null_page;
+		}
+	}
+
+	uint32_t *page = memnew_arr(uint32_t, PAGE_SIZE);
+	memset(page, 0, sizeof(uint32_t) * PAGE_SIZE);
+	pages[p_page] = page;
+}
@@ -0,0 +1,95 @@
+#pragma once
+
+#include "../ecs_types.h"
+#include "core/templates/local_vector.h"
+
+/// Sparse array that maps an `Entity` index to an `uint32_t`, `UINT32_MAX`
+/// when not set. Used by the sparse sets (`DenseVector`, `EntityList`).
+///
+/// The memory is paged: a page is allocated only when one of its indices is
+/// set, and all the missing pages point to the same shared empty page. So a
+/// storage that holds a single `Entity` with a big index allocates a single
+/// page, while reading is still two loads (the page and the value) with no
+/// branch on the page.
+///
+/// The values are stored incremented by one, so the shared page is all zeros
+/// and doesn't need any initialization.
+class PagedSparseArray {
+public:
+	static constexpr uint32_t PAGE_SHIFT = 12;
+	static constexpr uint32_t PAGE_SIZE = 1 << PAGE_SHIFT;
+	static constexpr uint32_t PAGE_MASK = PAGE_SIZE - 1;
+
+private:
+	/// Each page is either owned, or the shared `null_page`.
+	LocalVector<uint32_t *> pages;
+
+	static uint32_t null_page[PAGE_SIZE];
+
+public:
+	PagedSparseArray() = default;
+	PagedSparseArray(const PagedSparseArray &p_other);
+	PagedSparseArray &operator=(const PagedSparseArray &p_other);
+	~PagedSparseArray();
+
+	_FORCE_INLINE_ uint32_t get(uint32_t p_index) const {
+		const uint32_t page = p_index >> PAGE_SHIFT;
+		// The unset values are `0`, that wraps to `UINT32_MAX`.
+		return page < pages.size() ? pages[page][p_index & PAGE_MASK] - 1 : UINT32_MAX;
+	}
+
+	_FORCE_INLINE_ bool has(uint32_t p_index) const {
+		return get(p_index) != UINT32_MAX;
+	}
+
+	/// Sets the value, allocating the page if needed. Setting `UINT32_MAX`
+	/// never allocates.
+	_FORCE_INLINE_ void set(uint32_t p_index, uint32_t p_value) {
+		const uint32_t page = p_index >> PAGE_SHIFT;
+		if (unlikely(page >= pages.size() || pages[page] == null_page)) {
+			if (p_value == UINT32_MAX) {
+				// Nothing to unset.
+				return;
+			}
+			create_page(page);
+		}
+		pages[page][p_index & PAGE_MASK] = p_value + 1;
+	}
+
+	/// Unsets the value.
+	_FORCE_INLINE_ void unset(uint32_t p_index) {
+		set(p_index, UINT32_MAX);
+	}
+
+	/// Calls `p_func(index, value)` for each set value. Proportional to the
+	/// allocated pages.
+	template <class F>
+	void for_each(F p_func) const {
+		for (uint32_t p = 0; p < pages.size(); p += 1) {
+			if (pages[p] == null_page) {
+				continue;
+			}
+			for (uint32_t i = 0; i < PAGE_SIZE; i += 1) {
+				if (pages[p][i] != 0) {
+					p_func((p << PAGE_SHIFT) | i, pages[p][i] - 1);
+				}
+			}
+		}
+	}
+
+	/// Allocates the pages needed to store the indices up to `p_size`.
+	void reserve(uint32_t p_size);
+
+	/// Unsets all the values, keeping the pages allocated. Proportional to the
+	/// allocated pages: when the set indices are known, prefer `unset` them.
+	void clear();
+
+	/// Frees all the pages.
+	void reset();
+
+	/// Returns the amount of allocated pages.
+	uint32_t get_allocated_page_count() const;
+
+private:
+	void create_page(uint32_t p_page);
+};
@@ -30,6 +30,11 @@ public:
 		return true;
 	}
 
+	virtual bool can_get_concurrently() const override {
+		// Many entities may point to the same component.
+		return false;
+	}
+
 	virtual godex::SID create_shared_component(const T &p_data) override {
 		T *d = allocator.alloc();
 		*d = p_data;
@@ -54,11 +59,16 @@ public:
 		return false;
 	}
 
+	virtual bool notifies_entity_signature() const override {
+		return true;
+	}
+
 	virtual void insert(EntityID p_entity, godex::SID p_id) override {
 		if (p_id < allocated_pointers.size()) {
 			if (allocated_pointers[p_id] != nullptr) {
 				storage.insert(p_entity, p_id);
 				StorageBase::notify_changed(p_entity);
+				StorageBase::notify_inserted(p_entity);
 				return;
 			}
 		}
@@ -112,9 +122,21 @@ public:
 		storage.remove(p_entity);
 		// Make sure to remove as changed.
 		StorageBase::notify_updated(p_entity);
+		StorageBase::notify_removed(p_entity);
+	}
+
+	virtual void remove_batch(const EntityID *p_entities, uint32_t p_count) override {
+		for (uint32_t i = 0; i < p_count; i += 1) {
+			// Check the internal storage: `has` returns `false` also when the
+			// shared component is freed.
+			if (storage.has(p_entities[i])) {
+				remove(p_entities[i]);
+			}
+		}
 	}
 
 	virtual void clear() override {
+		StorageBase::notify_removed_all();
 		allocator.reset();
 		allocated_pointers.reset();
 		storage.clear();
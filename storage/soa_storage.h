@@ -0,0 +1,229 @@
+#pragma once
+
+#include "../ecs.h"
+#include "core/os/memory.h"
+#include "core/templates/local_vector.h"
+#include "paged_sparse_array.h"
+#include "storage.h"
+#include <cstring>
+#include <type_traits>
+
+/// Structure of arrays storage, for the components made only of `real_t`s
+/// (like `Vector3`, `Quat`, `Basis` or plain `real_t` members): each `real_t`
+/// of the component is stored in its own array, aligned to
+/// `SOA_ALIGNMENT` bytes, so the math kernels can process many `Entities`
+/// with a single SIMD instruction.
+///
+/// The `real_t` number `N` of the component (in declaration order) is the
+/// field `N`, use `field_of` to get it from the member offset:
+/// ```
+/// struct Boid {
+/// 	COMPONENT(Boid, SoAStorage)
+/// 	static void _bind_methods() {}
+///
+/// 	Vector3 position;
+/// 	Vector3 velocity;
+/// };
+///
+/// void integrate_boids(SoAStorage<Boid> *p_boids, const FrameTime *p_time) {
+/// 	real_t *px = p_boids->get_field(SoAStorage<Boid>::field_of(offsetof(Boid, position.x)));
+/// 	const real_t *vx = p_boids->get_field(SoAStorage<Boid>::field_of(offsetof(Boid, velocity.x)));
+/// 	for (uint32_t i = 0; i < p_boids->size(); i += 1) {
+/// 		px[i] += vx[i] * p_time->delta;
+/// 	}
+/// }
+/// ```
+///
+/// The components are not stored as `T`, so the `Query` can't fetch them
+/// (it doesn't compile, see `is_soa_storage`): take the storage as `System`
+/// argument, and use `get_component` and `set_component` to access a single
+/// `Entity`. The changes done through the fields are not tracked by
+/// `Changed`.
+template <class T>
+class SoAStorage : public Storage<T> {
+	static_assert(std::is_trivially_copyable<T>::value, "The `SoAStorage` can store only trivially copyable components.");
+	static_assert(sizeof(T) % sizeof(real_t) == 0, "The `SoAStorage` can store only the components made of `real_t`s.");
+
+public:
+	static constexpr uint32_t FIELDS = sizeof(T) / sizeof(real_t);
+	static constexpr uint32_t SOA_ALIGNMENT = 64;
+
+private:
+	/// The capacity of each field array is a multiple of this, so all the
+	/// fields are aligned.
+	static constexpr uint32_t STRIDE_STEP = SOA_ALIGNMENT / sizeof(real_t);
+
+	LocalVector<EntityID> entities;
+	PagedSparseArray entity_to_index;
+
+	/// The allocated memory, `fields` is its aligned start.
+	uint8_t *memory = nullptr;
+	real_t *fields = nullptr;
+	uint32_t capacity = 0;
+
+public:
+	virtual ~SoAStorage() {
+		if (memory) {
+			memfree(memory);
+		}
+	}
+
+	virtual void configure(const Dictionary &p_config) override {
+		clear();
+		reserve(p_config.get("pre_allocate", 0));
+	}
+
+	virtual String get_type_name() const override {
+		return "SoAStorage[" + String(typeid(T).name()) + "]";
+	}
+
+	virtual bool notifies_entity_signature() const override {
+		return true;
+	}
+
+	/// Returns the field index of the `real_t` at the offset `p_offset` of the
+	/// component.
+	static constexpr uint32_t field_of(size_t p_offset) {
+		return p_offset / sizeof(real_t);
+	}
+
+	/// Returns the amount of stored components: the length of each field.
+	uint32_t size() const {
+		return entities.size();
+	}
+
+	/// Returns the array of the field `p_field`, sorted as `get_entities`.
+	/// The pointer is valid till a component is inserted or removed.
+	_FORCE_INLINE_ real_t *get_field(uint32_t p_field) {
+		CRASH_BAD_UNSIGNED_INDEX(p_field, FIELDS);
+		return fields + (p_field * capacity);
+	}
+
+	_FORCE_INLINE_ const real_t *get_field(uint32_t p_field) const {
+		CRASH_BAD_UNSIGNED_INDEX(p_field, FIELDS);
+		return fields + (p_field * capacity);
+	}
+
+	const EntityID *get_entities() const {
+		return entities.ptr();
+	}
+
+	/// Allocates the memory for `p_capacity` components.
+	void reserve(uint32_t p_capacity) {
+		if (p_capacity <= capacity) {
+			return;
+		}
+		const uint32_t new_capacity = ((p_capacity + STRIDE_STEP - 1) / STRIDE_STEP) * STRIDE_STEP;
+		uint8_t *new_memory = (uint8_t *)memalloc(sizeof(real_t) * FIELDS * new_capacity + SOA_ALIGNMENT);
+		real_t *new_fields = (real_t *)(((uintptr_t)new_memory + SOA_ALIGNMENT - 1) & ~uintptr_t(SOA_ALIGNMENT - 1));
+		if (memory) {
+			for (uint32_t f = 0; f < FIELDS; f += 1) {
+				memcpy(new_fields + (f * new_capacity), fields + (f * capacity), sizeof(real_t) * entities.size());
+			}
+			memfree(memory);
+		}
+		memory = new_memory;
+		fields = new_fields;
+		capacity = new_capacity;
+	}
+
+	virtual void insert(EntityID p_entity, const T &p_data) override {
+		uint32_t index = entity_to_index.get(p_entity);
+		if (index == UINT32_MAX) {
+			if (entities.size() >= capacity) {
+				reserve(MAX(capacity * 2, STRIDE_STEP));
+			}
+			index = entities.size();
+			entity_to_index.set(p_entity, index);
+			entities.push_back(p_entity);
+		}
+		scatter(index, p_data);
+		StorageBase::notify_changed(p_entity);
+		StorageBase::notify_inserted(p_entity);
+	}
+
+	virtual bool has(EntityID p_entity) const override {
+		return entity_to_index.has(p_entity);
+	}
+
+	virtual T *get(EntityID p_entity, Space p_mode = Space::LOCAL) override {
+		ERR_PRINT("The `SoAStorage` doesn't store the components as `" + String(typeid(T).name()) + "`, use `get_component`, or the fields.");
+		return nullptr;
+	}
+
+	virtual const T *get(EntityID p_entity, Space p_mode = Space::LOCAL) const override {
+		ERR_PRINT("The `SoAStorage` doesn't store the components as `" + String(typeid(T).name()) + "`, use `get_component`, or the fields.");
+		return nullptr;
+	}
+
+	/// Returns a copy of the component of this `Entity`.
+	T get_component(EntityID p_entity) const {
+		const uint32_t index = entity_to_index.get(p_entity);
+		T data;
+		ERR_FAIL_COND_V_MSG(index == UINT32_MAX, data, "This entity doesn't have this component.");
+		uint8_t *bytes = reinterpret_cast<uint8_t *>(&data);
+		for (uint32_t f = 0; f < FIELDS; f += 1) {
+			memcpy(bytes + (f * sizeof(real_t)), fields + (f * capacity) + index, sizeof(real_t));
+		}
+		return data;
+	}
+
+	/// Sets the component of this `Entity`, that must already have it.
+	void set_component(EntityID p_entity, const T &p_data) {
+		const uint32_t index = entity_to_index.get(p_entity);
+		ERR_FAIL_COND_MSG(index == UINT32_MAX, "This entity doesn't have this component.");
+		scatter(index, p_data);
+		StorageBase::notify_changed(p_entity);
+	}
+
+	virtual void remove(EntityID p_entity) override {
+		const uint32_t index = entity_to_index.get(p_entity);
+		if (index == UINT32_MAX) {
+			return;
+		}
+		const uint32_t last = entities.size() - 1;
+		if (index != last) {
+			for (uint32_t f = 0; f < FIELDS; f += 1) {
+				real_t *field = fields + (f * capacity);
+				field[index] = field[last];
+			}
+			entities[index] = entities[last];
+			entity_to_index.set(entities[index], index);
+		}
+		entities.resize(last);
+		entity_to_index.unset(p_entity);
+
+		// Make sure to remove as changed.
+		StorageBase::notify_updated(p_entity);
+		StorageBase::notify_removed(p_entity);
+	}
+
+	virtual void clear() override {
+		StorageBase::notify_removed_all();
+		for (uint32_t i = 0; i < entities.size(); i += 1) {
+			entity_to_index.unset(entities[i]);
+		}
+		entities.clear();
+		StorageBase::flush_changed();
+	}
+
+	virtual EntitiesBuffer get_stored_entities() const override {
+		return { entities.size(), entities.ptr() };
+	}
+
+private:
+	void scatter(uint32_t p_index, const T &p_data) {
+		const uint8_t *bytes = reinterpret_cast<const uint8_t *>(&p_data);
+		for (uint32_t f = 0; f < FIELDS; f += 1) {
+			memcpy(fields + (f * capacity) + p_index, bytes + (f * sizeof(real_t)), sizeof(real_t));
+		}
+	}
+};
+
+/// `true` when the storage class `S` is a `SoAStorage`: used by the `Query`
+/// to reject these components at compile time.
+template <class S>
+struct is_soa_storage : std::false_type {};
+
+template <class T>
+struct is_soa_storage<SoAStorage<T>> : std::true_type {};
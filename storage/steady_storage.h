@@ -35,11 +35,16 @@ public:
 		return true;
 	}
 
+	virtual bool notifies_entity_signature() const override {
+		return true;
+	}
+
 	virtual void insert(EntityID p_entity, const T &p_data) override {
 		T *d = allocator.alloc();
 		*d = p_data;
 		storage.insert(p_entity, d);
 		StorageBase::notify_changed(p_entity);
+		StorageBase::notify_inserted(p_entity);
 	}
 
 	virtual bool has(EntityID p_entity) const override {
@@ -62,9 +67,11 @@ public:
 		allocator.free(d);
 		// Make sure to remove as changed.
 		StorageBase::notify_updated(p_entity);
+		StorageBase::notify_removed(p_entity);
 	}
 
 	virtual void clear() override {
+		StorageBase::notify_removed_all();
 		allocator.reset();
 		storage.clear();
 		StorageBase::flush_changed();
@@ -0,0 +1,4 @@
+#include "storage.h"
+
+thread_local LocalVector<RecordedChange> *StorageBase::recorded_changes = nullptr;
+thread_local SystemTicks StorageBase::system_ticks;
@@ -1,6 +1,10 @@
 #pragma once
 
 #include "entity_list.h"
+#include "entity_signatures.h"
+#include "paged_sparse_array.h"
+#include <atomic>
+#include <type_traits>
 
 /// Some stroages support `Entity` nesting, you can get local or global space
 /// data, by specifying one or the other.
@@ -17,12 +21,59 @@ struct EntitiesBuffer {
 			count(c), entities(e) {}
 };
 
+class StorageBase;
+
+/// A change notified while the storage was accessed concurrently.
+struct RecordedChange {
+	StorageBase *storage;
+	EntityID entity;
+};
+
+/// The change ticks of the `System` running on the current thread.
+struct SystemTicks {
+	/// The tick assigned to this `System` execution, `0` outside a `System`.
+	uint32_t tick = 0;
+	/// The tick of the previous execution of this `System`.
+	uint32_t last_run = 0;
+};
+
 /// Never override this directly. Always override the `Storage`.
 class StorageBase {
 	bool tracing_change = false;
-	EntityList changed;
+	/// The tick of the last change of each `Entity`, `0` means never changed.
+	/// `Changed` compares it with the last run of the `System`, so each
+	/// `System` sees the changes done since its previous execution.
+	/// Stored decremented by one, so the unset value is the tick `0`.
+	PagedSparseArray change_ticks;
+	/// The changes up to this tick are ignored, set by `flush_changed`.
+	uint32_t flushed_tick = 0;
+
+	/// The tick counter of the `World`, `own_change_tick` if not set.
+	std::atomic<uint32_t> *change_tick = nullptr;
+	std::atomic<uint32_t> own_change_tick;
+
+	static thread_local SystemTicks system_ticks;
+
+	/// Set by the `World`, used to keep track of the components of each
+	/// `Entity`.
+	EntitySignatures *entity_signatures = nullptr;
+	godex::component_id signature_component = godex::COMPONENT_NONE;
+
+	/// When set, the changes notified by the current thread are recorded here
+	/// and applied later, instead to be immediately stored into `change_ticks`.
+	static thread_local LocalVector<RecordedChange> *recorded_changes;
+
+	/// The `Entities` inserted or removed since the last trim, read by the
+	/// `QueryCache`s to update their matches. Recorded only once enabled.
+	bool structural_log_enabled = false;
+	LocalVector<EntityID> structural_log;
+	/// The absolute position of the first entry of `structural_log`.
+	uint64_t structural_log_begin = 0;
 
 public:
+	StorageBase() :
+			own_change_tick(1) {}
+
 	/// This function is called each time this storage is initialized.
 	/// It's possible to provide configuration by passing a dictionary.
 	virtual void configure(const Dictionary &p_config) {}
@@ -42,6 +93,13 @@ public:
 		return false;
 	}
 
+	/// Returns `true` when the storage shares its internal structure with other
+	/// storages (like the `ArchetypeStorage`): in such case, adding or
+	/// removing a component may alter the other storages.
+	virtual bool is_structure_shared() const {
+		return false;
+	}
+
 	virtual bool has(EntityID p_entity) const {
 		CRASH_NOW_MSG("Override this function.");
 		return false;
@@ -70,14 +128,187 @@ public:
 		CRASH_NOW_MSG("Override this function.");
 	}
 
+	/// Removes the components of all these entities, the entities that are not
+	/// stored are skipped. Override it if the storage can do it faster.
+	virtual void remove_batch(const EntityID *p_entities, uint32_t p_count) {
+		for (uint32_t i = 0; i < p_count; i += 1) {
+			if (has(p_entities[i])) {
+				remove(p_entities[i]);
+			}
+		}
+	}
+
+	/// Returns `true` when the storage calls `notify_inserted` and
+	/// `notify_removed` each time a component is added or removed: the `World`
+	/// relies on it to know which storages hold an `Entity`, without asking
+	/// to all of them.
+	virtual bool notifies_entity_signature() const {
+		return false;
+	}
+
 	virtual EntitiesBuffer get_stored_entities() const {
 		CRASH_NOW_MSG("Override this function.");
 		return { 0, nullptr };
 	}
 
+	/// Returns `true` when `sort_by_entity` has something to do.
+	virtual bool needs_sort() const {
+		return false;
+	}
+
+	/// Reorders the components by ascending `EntityID`, so the `Query`s that
+	/// fetch many storages walk the memory in lockstep. Called by the `World`
+	/// during `flush`, never while a `System` runs: it moves at most
+	/// `p_max_swaps` components, and returns how many it moved.
+	virtual uint32_t sort_by_entity(uint32_t p_max_swaps) {
+		return 0;
+	}
+
+	/// Returns the components packed into a single array, sorted as
+	/// `get_stored_entities()`; or `nullptr` when the storage doesn't store
+	/// them contiguously. The `Query` uses it to iterate by chunks.
+	virtual void *get_dense_data() {
+		return nullptr;
+	}
+
 	virtual void on_system_release() {}
 
+	/// Called, for the storages that `notify_release_write`, before a stage
+	/// where some `System`s take this storage: no `System` is running, so the
+	/// storage can settle its pending changes here.
+	virtual void on_stage_read() {}
+
+	/// Returns `true` if the mutable `get` can be called concurrently, from
+	/// many threads, on different entities.
+	virtual bool can_get_concurrently() const {
+		return true;
+	}
+
+	/// Applies a change recorded while this storage was accessed concurrently.
+	/// Storages that track more than the changed list can override this, and
+	/// use `record_change` to defer their bookkeeping.
+	virtual void apply_recorded_change(EntityID p_entity) {
+		if (tracing_change) {
+			set_change_tick(p_entity);
+		}
+	}
+
 public:
+	/// Starts recording the changes notified by the current thread into
+	/// `r_buffer`: this allows to mutably fetch the storages from many threads
+	/// at the same time.
+	static void begin_recording_changes(LocalVector<RecordedChange> *r_buffer) {
+		recorded_changes = r_buffer;
+	}
+
+	static void end_recording_changes() {
+		recorded_changes = nullptr;
+	}
+
+	static bool is_recording_changes() {
+		return recorded_changes != nullptr;
+	}
+
+	/// Applies the recorded changes. Must be called once no other thread is
+	/// accessing the storages.
+	static void apply_recorded_changes(const LocalVector<RecordedChange> &p_buffer) {
+		for (uint32_t i = 0; i < p_buffer.size(); i += 1) {
+			p_buffer[i].storage->apply_recorded_change(p_buffer[i].entity);
+		}
+	}
+
+	void set_entity_signatures(EntitySignatures *p_signatures, godex::component_id p_component) {
+		entity_signatures = p_signatures;
+		signature_component = p_component;
+	}
+
+	/// Must be called by the storage each time a component is added.
+	void notify_inserted(EntityID p_entity) {
+		if (entity_signatures != nullptr) {
+			entity_signatures->insert(p_entity, signature_component);
+		}
+		if (structural_log_enabled) {
+			structural_log.push_back(p_entity);
+		}
+	}
+
+	/// Must be called by the storage each time a component is removed.
+	void notify_removed(EntityID p_entity) {
+		if (entity_signatures != nullptr) {
+			entity_signatures->remove(p_entity, signature_component);
+		}
+		if (structural_log_enabled) {
+			structural_log.push_back(p_entity);
+		}
+	}
+
+	/// Calls `notify_removed` for all the stored entities, use it before
+	/// clearing the storage.
+	void notify_removed_all() {
+		if (entity_signatures != nullptr) {
+			const EntitiesBuffer stored = get_stored_entities();
+			for (uint32_t i = 0; i < stored.count; i += 1) {
+				entity_signatures->remove(stored.entities[i], signature_component);
+			}
+		}
+		if (structural_log_enabled) {
+			// Skip past the end, so all the readers rebuild.
+			structural_log_begin += structural_log.size() + 1;
+			structural_log.clear();
+		}
+	}
+
+	/// Starts recording the inserted and removed `Entities`; the storage must
+	/// `notifies_entity_signature()`.
+	void enable_structural_log() {
+		structural_log_enabled = true;
+	}
+
+	/// Returns the absolute position of the first logged entry: a reader
+	/// positioned before it missed some entries, and must rebuild.
+	uint64_t get_structural_log_begin() const {
+		return structural_log_begin;
+	}
+
+	/// Returns the absolute position past the last logged entry.
+	uint64_t get_structural_log_end() const {
+		return structural_log_begin + structural_log.size();
+	}
+
+	EntityID get_structural_log_entry(uint64_t p_position) const {
+		return structural_log[p_position - structural_log_begin];
+	}
+
+	/// Drops the logged entries. Called by the `World` during `flush`.
+	void trim_structural_log() {
+		structural_log_begin += structural_log.size();
+		structural_log.clear();
+	}
+
+	/// Set by the `World`: all its storages share the same tick counter.
+	void set_change_tick_counter(std::atomic<uint32_t> *p_counter) {
+		change_tick = p_counter;
+	}
+
+	/// Returns the ticks of the `System` running on this thread.
+	static SystemTicks get_system_ticks() {
+		return system_ticks;
+	}
+
+	/// Set by the `Pipeline` while a `System` runs on this thread; returns the
+	/// previous ticks.
+	static SystemTicks set_system_ticks(const SystemTicks &p_ticks) {
+		const SystemTicks previous = system_ticks;
+		system_ticks = p_ticks;
+		return previous;
+	}
+
+	/// Returns `true` if the tick `p_tick` comes after `p_than`, even when the
+	/// counter wraps around.
+	static _FORCE_INLINE_ bool is_tick_newer(uint32_t p_tick, uint32_t p_than) {
+		return int32_t(p_tick - p_than) > 0;
+	}
+
 	void set_tracing_change(bool p_need_changed) {
 		tracing_change = p_need_changed;
 	}
@@ -88,36 +319,82 @@ public:
 
 	void notify_changed(EntityID p_entity) {
 		if (tracing_change) {
-			changed.insert(p_entity);
+			if (unlikely(recorded_changes != nullptr)) {
+				recorded_changes->push_back({ this, p_entity });
+			} else {
+				set_change_tick(p_entity);
+			}
 		}
 	}
 
+	/// Records a change, for this storage, on the current thread buffer. Use it
+	/// only when `is_recording_changes()` returns `true`.
+	void record_change(EntityID p_entity) {
+		recorded_changes->push_back({ this, p_entity });
+	}
+
 	void notify_updated(EntityID p_entity) {
 		if (tracing_change) {
-			changed.remove(p_entity);
+			change_ticks.unset(p_entity.get_index());
 		}
 	}
 
+	/// Returns `true` if the component changed after the last execution of
+	/// the running `System`, and after the last `flush_changed`.
 	bool is_changed(EntityID p_entity) const {
-		if (tracing_change) {
-			return changed.has(p_entity);
+		if (tracing_change == false) {
+			return false;
 		}
-		return false;
+		const uint32_t tick = change_ticks.get(p_entity.get_index()) + 1;
+		if (tick == 0 || is_tick_newer(tick, flushed_tick) == false) {
+			return false;
+		}
+		return system_ticks.tick == 0 || is_tick_newer(tick, system_ticks.last_run);
 	}
 
+	/// Marks all the current changes as seen, for all the `System`s.
 	void flush_changed() {
 		if (tracing_change) {
-			changed.clear();
+			flushed_tick = get_change_tick_counter().fetch_add(1, std::memory_order_relaxed) + 1;
 		}
 	}
 
 	/// Used to hard reset the changed storage.
 	void reset_changed() {
-		changed.reset();
+		change_ticks.reset();
+		flushed_tick = 0;
+	}
+
+	/// Forgets the changes older than `p_oldest`, so the remaining ticks can
+	/// be compared even when the counter wraps around. Called periodically by
+	/// the `World`.
+	void rebase_change_ticks(uint32_t p_oldest) {
+		if (tracing_change == false) {
+			return;
+		}
+		if (is_tick_newer(p_oldest, flushed_tick)) {
+			flushed_tick = p_oldest;
+		}
+		change_ticks.for_each([&](uint32_t p_index, uint32_t p_value) {
+			if (is_tick_newer(p_value + 1, flushed_tick) == false) {
+				change_ticks.unset(p_index);
+			}
+		});
+	}
+
+private:
+	std::atomic<uint32_t> &get_change_tick_counter() {
+		return change_tick != nullptr ? *change_tick : own_change_tick;
 	}
 
-	EntitiesBuffer get_changed_entities() const {
-		return EntitiesBuffer(changed.size(), changed.get_entities_ptr());
+	void set_change_tick(EntityID p_entity) {
+		// Outside a `System`, the change is newer than any executed `System`.
+		uint32_t tick = system_ticks.tick != 0 ? system_ticks.tick : get_change_tick_counter().load(std::memory_order_relaxed) + 1;
+		if (unlikely(tick == 0)) {
+			// The counter wrapped: `0` means never changed.
+			tick = 1;
+		}
+		change_ticks.set(p_entity.get_index(), tick - 1);
 	}
 
 public:
@@ -218,6 +495,22 @@ public:
 		CRASH_NOW_MSG("Override this function.");
 	}
 
+	/// Inserts the same component to `p_count` contiguous entities, starting
+	/// from `p_first`. Override it when the storage can do it faster.
+	virtual void insert_batch(EntityID p_first, uint32_t p_count, const T &p_data) {
+		for (uint32_t i = 0; i < p_count; i += 1) {
+			insert(EntityID(p_first.get_index() + i, p_first.get_generation()), p_data);
+		}
+	}
+
+	/// Inserts `p_count` components, one per `Entity`. Override it when the
+	/// storage can do it faster.
+	virtual void insert_list(const EntityID *p_entities, const T *p_data, uint32_t p_count) {
+		for (uint32_t i = 0; i < p_count; i += 1) {
+			insert(p_entities[i], p_data[i]);
+		}
+	}
+
 	virtual T *get(EntityID p_entity, Space p_mode = Space::LOCAL) {
 		CRASH_NOW_MSG("Override this function.");
 		return nullptr;
@@ -300,3 +593,16 @@ public:
 		ERR_PRINT("This component is stored inside a SharedStorage, so you can't just insert the data using the normal `insert` function. Check the documentation.");
 	}
 };
+
+/// The concrete storage type of the component `C`, known at compile time for
+/// the components declared with `COMPONENT` and `COMPONENT_BATCH` (through
+/// `C::StorageClass`); `void` otherwise.
+template <class C, class = void>
+struct component_storage_class {
+	using type = void;
+};
+
+template <class C>
+struct component_storage_class<C, std::void_t<typename C::StorageClass>> {
+	using type = typename C::StorageClass;
+};
@@ -0,0 +1,111 @@
+#include "storage_group.h"
+
+StorageGroup::StorageGroup(const StringName &p_name) :
+		name(p_name) {}
+
+const StringName &StorageGroup::get_name() const {
+	return name;
+}
+
+void StorageGroup::add_member(GroupStorageBase *p_storage, godex::component_id p_component_id) {
+	ERR_FAIL_COND_MSG(p_storage->group != nullptr, "This storage is already owned by a group.");
+	p_storage->group = this;
+	members.push_back(p_storage);
+	components.push_back(p_component_id);
+	rebuild();
+}
+
+void StorageGroup::remove_member(GroupStorageBase *p_storage) {
+	const int64_t index = members.find(p_storage);
+	ERR_FAIL_COND_MSG(index < 0, "This storage is not owned by the group " + name + ".");
+	p_storage->group = nullptr;
+	members.remove(index);
+	components.remove(index);
+	rebuild();
+}
+
+const LocalVector<godex::component_id> &StorageGroup::get_components() const {
+	return components;
+}
+
+bool StorageGroup::has_exactly(const godex::component_id *p_components, uint32_t p_count) const {
+	if (p_count != components.size()) {
+		return false;
+	}
+	for (uint32_t i = 0; i < p_count; i += 1) {
+		if (components.find(p_components[i]) < 0) {
+			return false;
+		}
+	}
+	return true;
+}
+
+uint32_t StorageGroup::get_size() const {
+	return size;
+}
+
+EntitiesBuffer StorageGroup::get_entities() const {
+	if (members.size() == 0) {
+		return { 0, nullptr };
+	}
+	return { size, members[0]->get_group_entities().entities };
+}
+
+void StorageGroup::on_insert(EntityID p_entity) {
+	if (members.size() == 0 || members[0]->group_has(p_entity) == false || members[0]->get_group_slot(p_entity) < size) {
+		// Not in the first storage, or already grouped.
+		return;
+	}
+	for (uint32_t i = 1; i < members.size(); i += 1) {
+		if (members[i]->group_has(p_entity) == false) {
+			return;
+		}
+	}
+
+	// The `Entity` has all the components: move it at the end of the prefix.
+	for (uint32_t i = 0; i < members.size(); i += 1) {
+		const uint32_t slot = members[i]->get_group_slot(p_entity);
+		if (slot != size) {
+			members[i]->swap_group_slots(slot, size);
+		}
+	}
+	size += 1;
+}
+
+void StorageGroup::on_remove(EntityID p_entity) {
+	if (members.size() == 0 || members[0]->group_has(p_entity) == false || members[0]->get_group_slot(p_entity) >= size) {
+		// Not grouped.
+		return;
+	}
+
+	// Move it just after the prefix, in all the storages.
+	size -= 1;
+	for (uint32_t i = 0; i < members.size(); i += 1) {
+		const uint32_t slot = members[i]->get_group_slot(p_entity);
+		if (slot != size) {
+			members[i]->swap_group_slots(slot, size);
+		}
+	}
+}
+
+void StorageGroup::on_clear() {
+	size = 0;
+}
+
+void StorageGroup::rebuild() {
+	size = 0;
+	if (members.size() == 0) {
+		return;
+	}
+
+	// Copy the `Entities`, since the partitioning reorders them.
+	const EntitiesBuffer entities = members[0]->get_group_entities();
+	LocalVector<EntityID> to_check;
+	to_check.resize(entities.count);
+	for (uint32_t i = 0; i < entities.count; i += 1) {
+		to_check[i] = entities.entities[i];
+	}
+	for (uint32_t i = 0; i < to_check.size(); i += 1) {
+		on_insert(to_check[i]);
+	}
+}
@@ -0,0 +1,89 @@
+#pragma once
+
+#include "core/string/string_name.h"
+#include "core/templates/local_vector.h"
+#include "storage.h"
+
+class StorageGroup;
+
+/// Base class of the storages that can be owned by a `StorageGroup`: the
+/// storage must keep its components in a dense array, that the group can
+/// reorder.
+class GroupStorageBase {
+	friend class StorageGroup;
+
+protected:
+	StorageGroup *group = nullptr;
+
+public:
+	virtual ~GroupStorageBase() {}
+
+	StorageGroup *get_group() const {
+		return group;
+	}
+
+	virtual bool group_has(EntityID p_entity) const = 0;
+	/// Returns the dense slot of this `Entity`.
+	virtual uint32_t get_group_slot(EntityID p_entity) const = 0;
+	/// Swaps the components (and the `Entities`) of the two dense slots.
+	virtual void swap_group_slots(uint32_t p_a, uint32_t p_b) = 0;
+	/// Returns the `Entities`, sorted as the dense array.
+	virtual EntitiesBuffer get_group_entities() const = 0;
+};
+
+/// Owning group: keeps the dense arrays of its storages partitioned, so that
+/// the first `get_size()` slots of each storage refer to the same `Entities`,
+/// the ones that have all the components of the group.
+///
+/// A `Query` that fetches exactly the components of a group iterates just
+/// this prefix, without checking the other storages, and `Query::chunks`
+/// returns it as a single chunk.
+///
+/// The groups are declared through the storages config, giving the same
+/// `group` name to the components to group:
+/// ```
+/// world->storages_config = {
+/// 	"BtRigidBody": {"group": "physics"},
+/// 	"TransformComponent": {"group": "physics"},
+/// }
+/// ```
+///
+/// Note: a storage can be owned by a single group, and the grouped storages
+/// are not sorted by `World::flush`.
+class StorageGroup {
+	StringName name;
+	LocalVector<GroupStorageBase *> members;
+	LocalVector<godex::component_id> components;
+	/// The amount of `Entities` that have all the components of the group.
+	uint32_t size = 0;
+
+public:
+	StorageGroup(const StringName &p_name);
+
+	const StringName &get_name() const;
+
+	/// Adds the storage to this group, and partitions its components.
+	void add_member(GroupStorageBase *p_storage, godex::component_id p_component_id);
+	void remove_member(GroupStorageBase *p_storage);
+
+	const LocalVector<godex::component_id> &get_components() const;
+
+	/// Returns `true` when the components of the group are exactly these.
+	bool has_exactly(const godex::component_id *p_components, uint32_t p_count) const;
+
+	/// Returns the amount of `Entities` that have all the components.
+	uint32_t get_size() const;
+
+	/// Returns the `Entities` that have all the components.
+	EntitiesBuffer get_entities() const;
+
+	/// Called by the member storages after inserting a component.
+	void on_insert(EntityID p_entity);
+	/// Called by the member storages before removing a component.
+	void on_remove(EntityID p_entity);
+	/// Called by the member storages when they are cleared.
+	void on_clear();
+
+private:
+	void rebuild();
+};
@@ -0,0 +1,130 @@
+#pragma once
+
+#include "core/templates/local_vector.h"
+#include "paged_sparse_array.h"
+#include "storage.h"
+#include <type_traits>
+
+/// Storage for the tag components: the markers without any data, like
+/// `Disabled`. Nothing is stored per `Entity`, a bitset tells which `Entities`
+/// have the tag, and a dense list is used to iterate them.
+///
+/// All the `Entities` share the same (empty) component instance, so the
+/// `Query` doesn't fetch it from the storage.
+///
+/// Use the `COMPONENT_TAG` macro to declare a tag:
+/// ```
+/// struct Frozen {
+/// 	COMPONENT_TAG(Frozen)
+/// 	static void _bind_methods() {}
+/// };
+/// ```
+template <class T>
+class TagStorage : public Storage<T> {
+	static_assert(std::is_empty<T>::value, "The `TagStorage` can store only the components without data.");
+
+	/// A bit per `Entity` index.
+	LocalVector<uint64_t> bits;
+	LocalVector<EntityID> entities;
+	/// The position of each `Entity` into `entities`, used to remove it.
+	PagedSparseArray entity_to_index;
+
+	static inline T tag;
+
+public:
+	virtual String get_type_name() const override {
+		return "TagStorage[" + String(typeid(T).name()) + "]";
+	}
+
+	virtual bool notifies_entity_signature() const override {
+		return true;
+	}
+
+	/// Returns the instance shared by all the `Entities`.
+	static _FORCE_INLINE_ T *get_tag() {
+		return &tag;
+	}
+
+	/// Not virtual `has`, used by the `Query`.
+	_FORCE_INLINE_ bool has_tag(EntityID p_entity) const {
+		const uint32_t word = p_entity.get_index() >> 6;
+		return word < bits.size() && (bits[word] & (uint64_t(1) << (p_entity.get_index() & 63))) != 0;
+	}
+
+	virtual void insert(EntityID p_entity, const T &p_data) override {
+		if (has_tag(p_entity) == false) {
+			const uint32_t word = p_entity.get_index() >> 6;
+			if (word >= bits.size()) {
+				const uint32_t start = bits.size();
+				bits.resize(word + 1);
+				for (uint32_t i = start; i < bits.size(); i += 1) {
+					bits[i] = 0;
+				}
+			}
+			bits[word] |= uint64_t(1) << (p_entity.get_index() & 63);
+			entity_to_index.set(p_entity, entities.size());
+			entities.push_back(p_entity);
+		}
+		StorageBase::notify_changed(p_entity);
+		StorageBase::notify_inserted(p_entity);
+	}
+
+	virtual bool has(EntityID p_entity) const override {
+		return has_tag(p_entity);
+	}
+
+	virtual T *get(EntityID p_entity, Space p_mode = Space::LOCAL) override {
+#ifdef DEBUG_ENABLED
+		CRASH_COND_MSG(has_tag(p_entity) == false, "This entity doesn't have this tag.");
+#endif
+		return &tag;
+	}
+
+	virtual const T *get(EntityID p_entity, Space p_mode = Space::LOCAL) const override {
+#ifdef DEBUG_ENABLED
+		CRASH_COND_MSG(has_tag(p_entity) == false, "This entity doesn't have this tag.");
+#endif
+		return &tag;
+	}
+
+	virtual void remove(EntityID p_entity) override {
+		if (has_tag(p_entity) == false) {
+			return;
+		}
+		bits[p_entity.get_index() >> 6] &= ~(uint64_t(1) << (p_entity.get_index() & 63));
+
+		const uint32_t index = entity_to_index.get(p_entity);
+		const uint32_t last = entities.size() - 1;
+		if (index != last) {
+			entities[index] = entities[last];
+			entity_to_index.set(entities[index], index);
+		}
+		entities.resize(last);
+		entity_to_index.unset(p_entity);
+
+		// Make sure to remove as changed.
+		StorageBase::notify_updated(p_entity);
+		StorageBase::notify_removed(p_entity);
+	}
+
+	virtual void clear() override {
+		StorageBase::notify_removed_all();
+		for (uint32_t i = 0; i < entities.size(); i += 1) {
+			bits[entities[i].get_index() >> 6] = 0;
+			entity_to_index.unset(entities[i]);
+		}
+		entities.clear();
+		StorageBase::flush_changed();
+	}
+
+	virtual EntitiesBuffer get_stored_entities() const override {
+		return { entities.size(), entities.ptr() };
+	}
+};
+
+/// `true` when the component `C` is stored by a `TagStorage`.
+template <class C, class = void>
+struct is_tag_component : std::false_type {};
+
+template <class C>
+struct is_tag_component<C, std::void_t<decltype(C::IS_TAG)>> : std::bool_constant<C::IS_TAG> {};
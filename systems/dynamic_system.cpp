@@ -264,6 +264,9 @@ void godex::DynamicSystemInfo::get_info(DynamicSystemInfo &p_info, func_system_e
 		p_info.target_sub_pipeline->get_systems_dependencies(r_out);
 	}
 
+	// The scripts and the sub pipelines are always executed alone.
+	r_out.exclusive = true;
+
 	r_out.system_func = p_exec;
 
 	// Arrived here, we can assume the system is valid.
@@ -11,22 +11,32 @@ typedef void (*func_system_execute)(World *p_world);
 
 struct SystemExeInfo {
 	bool valid = true;
+	/// The `System` name, used by the `PipelineProfiler`.
+	StringName name;
 	Set<uint32_t> mutable_components;
 	Set<uint32_t> immutable_components;
 	Set<uint32_t> mutable_components_storage;
 	Set<uint32_t> mutable_databags;
 	Set<uint32_t> immutable_databags;
 	Set<uint32_t> need_changed;
+	/// When `true` the `System` can't run in parallel with any other `System`.
+	bool exclusive = false;
+	/// When `true` the `System` records its structural changes into a
+	/// `CommandBuffer`.
+	bool uses_command_buffer = false;
 	func_system_execute system_func = nullptr;
 
 	void clear() {
 		valid = true;
+		name = StringName();
 		mutable_components.clear();
 		immutable_components.clear();
 		mutable_components_storage.clear();
 		mutable_databags.clear();
 		immutable_databags.clear();
 		need_changed.clear();
+		exclusive = false;
+		uses_command_buffer = false;
 		system_func = nullptr;
 	}
 };
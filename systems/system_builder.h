@@ -1,7 +1,10 @@
 #pragma once
 
 #include "../databags/databag.h"
+#include "../iterators/cached_query.h"
 #include "../iterators/query.h"
+#include "../storage/soa_storage.h"
+#include "../world/command_buffer.h"
 #include <type_traits>
 
 // TODO put all this into a CPP or a namespace?
@@ -27,6 +30,18 @@ struct InfoConstructor<Storage<C> *, Cs...> : InfoConstructor<Cs...> {
 	}
 };
 
+/// Fetches the `SoAStorage`, to access the fields of its components:
+/// ```
+/// void test_func(SoAStorage<Component> *p_component_storage){}
+/// ```
+template <class C, class... Cs>
+struct InfoConstructor<SoAStorage<C> *, Cs...> : InfoConstructor<Cs...> {
+	InfoConstructor(SystemExeInfo &r_info) :
+			InfoConstructor<Cs...>(r_info) {
+		r_info.mutable_components_storage.insert(C::get_component_id());
+	}
+};
+
 /// Fetches the argument `Query`.
 /// The query is supposed to be a mutable query reference:
 /// ```
@@ -40,6 +55,15 @@ struct InfoConstructor<Query<Qcs...> &, Cs...> : InfoConstructor<Cs...> {
 	}
 };
 
+/// Creates the `CachedQuery`.
+template <class... Qcs, class... Cs>
+struct InfoConstructor<CachedQuery<Qcs...> &, Cs...> : InfoConstructor<Cs...> {
+	InfoConstructor(SystemExeInfo &r_info) :
+			InfoConstructor<Cs...>(r_info) {
+		CachedQuery<Qcs...>::get_components(r_info);
+	}
+};
+
 /// Fetches the `Databag`.
 /// The `Databag` can be taken as mutable or immutable pointer.
 /// ```
@@ -58,6 +82,23 @@ struct InfoConstructor<D *, Cs...> : InfoConstructor<Cs...> {
 	}
 };
 
+/// Fetches the `CommandBuffer`, used to spawn and despawn `Entities` or to
+/// add and remove components: the changes are applied at the end of the stage.
+/// ```
+/// void test_func(CommandBuffer &p_commands){}
+/// ```
+template <class... Cs>
+struct InfoConstructor<CommandBuffer &, Cs...> : InfoConstructor<Cs...> {
+	InfoConstructor(SystemExeInfo &r_info) :
+			InfoConstructor<Cs...>(r_info) {
+		r_info.uses_command_buffer = true;
+		// `spawn` reserves the IDs through the `WorldCommands`, that is thread
+		// safe only against the other reservations: so it doesn't run with
+		// the `System`s that take the `WorldCommands` mutable.
+		r_info.immutable_databags.insert(WorldCommands::get_databag_id());
+	}
+};
+
 /// Creates a SystemExeInfo, extracting the information from a system function.
 template <class... RCs>
 void get_system_info_from_function(SystemExeInfo &r_info, void (*system_func)(RCs...)) {
@@ -78,6 +119,15 @@ struct DataFetcher<Storage<C> *> {
 			inner(p_world->get_storage<C>()) {}
 };
 
+/// SoAStorage
+template <class C>
+struct DataFetcher<SoAStorage<C> *> {
+	SoAStorage<C> *inner;
+
+	DataFetcher(World *p_world) :
+			inner(dynamic_cast<SoAStorage<C> *>(p_world->get_storage(C::get_component_id()))) {}
+};
+
 /// Query
 template <class... Cs>
 struct DataFetcher<Query<Cs...> &> {
@@ -87,6 +137,15 @@ struct DataFetcher<Query<Cs...> &> {
 			inner(p_world) {}
 };
 
+/// CachedQuery
+template <class... Cs>
+struct DataFetcher<CachedQuery<Cs...> &> {
+	CachedQuery<Cs...> inner;
+
+	DataFetcher(World *p_world) :
+			inner(p_world) {}
+};
+
 /// Databag
 template <class D>
 struct DataFetcher<D *> {
@@ -97,6 +156,15 @@ struct DataFetcher<D *> {
 	}
 };
 
+/// CommandBuffer
+template <>
+struct DataFetcher<CommandBuffer &> {
+	CommandBuffer &inner;
+
+	DataFetcher(World *p_world) :
+			inner(CommandBuffer::fetch(p_world)) {}
+};
+
 #define OBTAIN(name, T, world) auto name = DataFetcher<T>(world);
 
 // ~~~~ system_exec_func definition ~~~~ //
@@ -0,0 +1,364 @@
+#ifndef TEST_ECS_BENCHMARK_H
+#define TEST_ECS_BENCHMARK_H
+
+// The benchmarks are compiled only when building with `godex_benchmarks=yes`,
+// and can be executed alone:
+// ```
+// scons tests=yes godex_benchmarks=yes
+// godot --test --test-case="*[Benchmark]*"
+// ```
+// Each result is printed as a JSON line, starting with `{"benchmark":`:
+// ```
+// {"benchmark":"DenseVectorStorage/insert","entities":1000,"usec":25,"nsec_per_entity":25.0}
+// ```
+#ifdef GODEX_BENCHMARKS
+
+#include "tests/test_macros.h"
+
+#include "../components/child.h"
+#include "../ecs.h"
+#include "../iterators/query.h"
+#include "../modules/godot/components/transform_component.h"
+#include "../pipeline/pipeline.h"
+#include "../storage/batch_storage.h"
+#include "../storage/dense_vector_storage.h"
+#include "../storage/hierarchical_storage.h"
+#include "../storage/shared_steady_storage.h"
+#include "../storage/steady_storage.h"
+#include "../world/world.h"
+#include "core/os/os.h"
+
+struct BenchmarkDense {
+	COMPONENT(BenchmarkDense, DenseVectorStorage)
+
+	int value = 0;
+
+	BenchmarkDense(int p_value) :
+			value(p_value) {}
+};
+
+struct BenchmarkDense2 {
+	COMPONENT(BenchmarkDense2, DenseVectorStorage)
+
+	int value = 0;
+
+	BenchmarkDense2(int p_value) :
+			value(p_value) {}
+};
+
+struct BenchmarkDense3 {
+	COMPONENT(BenchmarkDense3, DenseVectorStorage)
+
+	int value = 0;
+
+	BenchmarkDense3(int p_value) :
+			value(p_value) {}
+};
+
+struct BenchmarkSteady {
+	COMPONENT(BenchmarkSteady, SteadyStorage)
+
+	int value = 0;
+
+	BenchmarkSteady(int p_value) :
+			value(p_value) {}
+};
+
+struct BenchmarkShared {
+	COMPONENT(BenchmarkShared, SharedSteadyStorage)
+
+	int value = 0;
+
+	BenchmarkShared(int p_value) :
+			value(p_value) {}
+};
+
+struct BenchmarkBatch {
+	COMPONENT_BATCH(BenchmarkBatch, DenseVector, 2)
+
+	int value = 0;
+
+	BenchmarkBatch(int p_value) :
+			value(p_value) {}
+};
+
+namespace godex_benchmarks {
+
+const uint32_t ENTITY_COUNTS[] = { 1000, 100000, 1000000 };
+
+void register_benchmark_components() {
+	static bool registered = false;
+	if (registered) {
+		return;
+	}
+	registered = true;
+	ECS::register_component<BenchmarkDense>();
+	ECS::register_component<BenchmarkDense2>();
+	ECS::register_component<BenchmarkDense3>();
+	ECS::register_component<BenchmarkSteady>();
+	ECS::register_component<BenchmarkShared>();
+	ECS::register_component<BenchmarkBatch>();
+}
+
+uint64_t now_usec() {
+	return OS::get_singleton()->get_ticks_usec();
+}
+
+/// Prints the result as a JSON line.
+void report(const String &p_benchmark, uint32_t p_entities, uint64_t p_usec) {
+	const double nsec_per_entity = p_entities == 0 ? 0.0 : (double(p_usec) * 1000.0) / double(p_entities);
+	print_line("{\"benchmark\":\"" + p_benchmark + "\",\"entities\":" + itos(p_entities) + ",\"usec\":" + itos(p_usec) + ",\"nsec_per_entity\":" + rtos(nsec_per_entity) + "}");
+}
+
+/// Measures insert, get and remove of the storage of `C`.
+/// `p_insert` adds the component to the `Entity`.
+template <class C, class F>
+void benchmark_storage(const String &p_storage, F p_insert) {
+	for (uint32_t count : ENTITY_COUNTS) {
+		World world;
+		for (uint32_t i = 0; i < count; i += 1) {
+			world.create_entity_index();
+		}
+
+		uint64_t begin = now_usec();
+		for (uint32_t i = 0; i < count; i += 1) {
+			p_insert(world, EntityID(i, 0), i);
+		}
+		report(p_storage + "/insert", count, now_usec() - begin);
+
+		Storage<C> *storage = world.get_storage<C>();
+		REQUIRE(storage != nullptr);
+
+		int sum = 0;
+		begin = now_usec();
+		for (uint32_t i = 0; i < count; i += 1) {
+			sum += storage->get(EntityID(i, 0))->value;
+		}
+		report(p_storage + "/get", count, now_usec() - begin);
+		CHECK(sum != -1);
+
+		begin = now_usec();
+		for (uint32_t i = 0; i < count; i += 1) {
+			storage->remove(EntityID(i, 0));
+		}
+		report(p_storage + "/remove", count, now_usec() - begin);
+	}
+}
+
+/// Measures the iteration of the `Query`, the `Entities` are already created.
+template <class... Cs>
+void benchmark_query(const String &p_name, World &p_world, uint32_t p_count) {
+	const uint64_t begin = now_usec();
+	Query<Cs...> query(&p_world);
+	uint32_t fetched = 0;
+	for (auto result : query) {
+		(void)result;
+		fetched += 1;
+	}
+	report("Query/" + p_name, p_count, now_usec() - begin);
+	CHECK(fetched <= p_count);
+}
+
+void benchmark_move_system(Query<BenchmarkDense, const BenchmarkDense2> &p_query) {
+	for (auto [a, b] : p_query) {
+		a->value += b->value;
+	}
+}
+
+void benchmark_changed_system(Query<Changed<const BenchmarkDense>, BenchmarkDense3> &p_query) {
+	for (auto [a, c] : p_query) {
+		c->value = a->value;
+	}
+}
+
+void benchmark_storage_system(Storage<BenchmarkSteady> *p_storage) {
+	const EntitiesBuffer entities = p_storage->get_stored_entities();
+	for (uint32_t i = 0; i < entities.count; i += 1) {
+		p_storage->get(entities.entities[i])->value += 1;
+	}
+}
+
+TEST_CASE("[Modules][ECS][Benchmark] Storages.") {
+	register_benchmark_components();
+
+	benchmark_storage<BenchmarkDense>("DenseVectorStorage", [](World &p_world, EntityID p_entity, uint32_t p_i) {
+		p_world.add_component(p_entity, BenchmarkDense(p_i));
+	});
+
+	benchmark_storage<BenchmarkSteady>("SteadyStorage", [](World &p_world, EntityID p_entity, uint32_t p_i) {
+		p_world.add_component(p_entity, BenchmarkSteady(p_i));
+	});
+
+	{
+		// All the `Entities` share a few components.
+		godex::SID shared[8];
+		World *current = nullptr;
+		benchmark_storage<BenchmarkShared>("SharedSteadyStorage", [&](World &p_world, EntityID p_entity, uint32_t p_i) {
+			if (current != &p_world) {
+				current = &p_world;
+				for (uint32_t s = 0; s < 8; s += 1) {
+					shared[s] = p_world.create_shared_component(BenchmarkShared(s));
+				}
+			}
+			p_world.add_shared_component(p_entity, BenchmarkShared::get_component_id(), shared[p_i % 8]);
+		});
+	}
+
+	benchmark_storage<BenchmarkBatch>("BatchStorage", [](World &p_world, EntityID p_entity, uint32_t p_i) {
+		p_world.add_component(p_entity, BenchmarkBatch(p_i));
+		p_world.add_component(p_entity, BenchmarkBatch(p_i));
+	});
+
+	for (uint32_t count : ENTITY_COUNTS) {
+		// Half of the `Entities` are children of the previous one.
+		World world;
+		uint64_t begin = now_usec();
+		for (uint32_t i = 0; i < count; i += 1) {
+			const EntityBuilder &entity = world.create_entity().with(TransformComponent());
+			if (i % 2 == 1) {
+				entity.with(Child(i - 1));
+			}
+		}
+		report("HierarchicalStorage/insert", count, now_usec() - begin);
+
+		Storage<TransformComponent> *storage = world.get_storage<TransformComponent>();
+		REQUIRE(storage != nullptr);
+
+		begin = now_usec();
+		real_t sum = 0.0;
+		for (uint32_t i = 0; i < count; i += 1) {
+			sum += storage->get(EntityID(i, 0), Space::GLOBAL)->transform.origin.x;
+		}
+		report("HierarchicalStorage/get_global", count, now_usec() - begin);
+		CHECK(sum == 0.0);
+
+		begin = now_usec();
+		for (uint32_t i = 0; i < count; i += 1) {
+			storage->remove(EntityID(i, 0));
+		}
+		report("HierarchicalStorage/remove", count, now_usec() - begin);
+	}
+}
+
+TEST_CASE("[Modules][ECS][Benchmark] EntityList clear.") {
+	// Only a few entities are stored, but the `EntityID`s are spread up to
+	// `count`: `clear` must not depend on the biggest `EntityID`.
+	const uint32_t stored = 64;
+	const uint32_t frames = 100;
+	for (uint32_t count : ENTITY_COUNTS) {
+		EntityList list;
+		list.insert(count - 1);
+
+		const uint64_t begin = now_usec();
+		for (uint32_t f = 0; f < frames; f += 1) {
+			for (uint32_t i = 0; i < stored; i += 1) {
+				list.insert((i * 7919 + f) % count);
+			}
+			list.clear();
+		}
+		report("EntityList/clear_" + itos(stored) + "_stored", count, (now_usec() - begin) / frames);
+		CHECK(list.is_empty());
+	}
+}
+
+TEST_CASE("[Modules][ECS][Benchmark] Query filters.") {
+	register_benchmark_components();
+
+	for (uint32_t count : ENTITY_COUNTS) {
+		World world;
+
+		// All the `Entities` have `BenchmarkDense`, half `BenchmarkDense2` and
+		// one third `BenchmarkDense3`. The first `Entity` creates the storage,
+		// so the changes of the others are traced.
+		world.add_component(world.create_entity_index(), BenchmarkDense(0));
+		world.get_storage(BenchmarkDense::get_component_id())->set_tracing_change(true);
+		for (uint32_t i = 1; i < count; i += 1) {
+			const EntityBuilder &entity = world.create_entity().with(BenchmarkDense(i));
+			if (i % 2 == 0) {
+				entity.with(BenchmarkDense2(i));
+			}
+			if (i % 3 == 0) {
+				entity.with(BenchmarkDense3(i));
+			}
+			entity.with(BenchmarkBatch(i));
+			entity.with(BenchmarkBatch(i));
+		}
+
+		benchmark_query<BenchmarkDense, const BenchmarkDense2>("plain", world, count);
+		benchmark_query<Changed<const BenchmarkDense>>("Changed", world, count);
+		benchmark_query<BenchmarkDense, Not<BenchmarkDense2>>("Not", world, count);
+		benchmark_query<BenchmarkDense, Maybe<BenchmarkDense2>>("Maybe", world, count);
+		benchmark_query<Any<BenchmarkDense2, BenchmarkDense3>>("Any", world, count);
+		benchmark_query<Join<BenchmarkDense2, BenchmarkDense3>>("Join", world, count);
+		benchmark_query<Batch<const BenchmarkBatch>>("Batch", world, count);
+	}
+}
+
+TEST_CASE("[Modules][ECS][Benchmark] Hierarchy flush.") {
+	// Animated rigs: chains of `depth` bones, all moved each frame, children
+	// first. Each bone is propagated once, so the cost per `Entity` doesn't
+	// grow with the depth.
+	const uint32_t frames = 10;
+	for (uint32_t depth : { 4, 64 }) {
+		for (uint32_t count : ENTITY_COUNTS) {
+			Hierarchy hierarchy;
+			HierarchicalStorage<TransformComponent> transform_storage;
+			hierarchy.add_sub_storage(&transform_storage);
+
+			for (uint32_t i = 0; i < count; i += 1) {
+				if (i % depth != 0) {
+					hierarchy.insert(i, Child(i - 1));
+				}
+			}
+			for (uint32_t i = 0; i < count; i += 1) {
+				transform_storage.insert(i, TransformComponent());
+			}
+
+			const uint64_t begin = now_usec();
+			for (uint32_t f = 0; f < frames; f += 1) {
+				for (uint32_t i = count; i > 0; i -= 1) {
+					transform_storage.get(i - 1)->transform.origin.x = f;
+				}
+				transform_storage.flush_changes();
+			}
+			report("HierarchicalStorage/flush_all_dirty_depth_" + itos(depth), count, (now_usec() - begin) / frames);
+		}
+	}
+}
+
+TEST_CASE("[Modules][ECS][Benchmark] Pipeline dispatch.") {
+	register_benchmark_components();
+
+	for (uint32_t count : ENTITY_COUNTS) {
+		World world;
+		for (uint32_t i = 0; i < count; i += 1) {
+			const EntityBuilder &entity = world.create_entity().with(BenchmarkDense(i)).with(BenchmarkSteady(i));
+			if (i % 2 == 0) {
+				entity.with(BenchmarkDense2(i));
+			}
+			if (i % 3 == 0) {
+				entity.with(BenchmarkDense3(i));
+			}
+		}
+
+		Pipeline pipeline;
+		pipeline.add_system(benchmark_move_system);
+		pipeline.add_system(benchmark_changed_system);
+		pipeline.add_system(benchmark_storage_system);
+		pipeline.build();
+		pipeline.prepare(&world);
+
+		const uint32_t frames = 10;
+		const uint64_t begin = now_usec();
+		for (uint32_t f = 0; f < frames; f += 1) {
+			pipeline.dispatch(&world);
+			world.flush();
+		}
+		report("Pipeline/dispatch", count, (now_usec() - begin) / frames);
+	}
+}
+} // namespace godex_benchmarks
+
+#endif // GODEX_BENCHMARKS
+
+#endif // TEST_ECS_BENCHMARK_H
@@ -50,6 +50,26 @@ TEST_CASE("[Modules][ECS] Test ECS EntityList.") {
 	changed.clear();
 	CHECK(changed.is_empty());
 
+	// Make sure `clear` resets all the stored entities, even far apart.
+	{
+		changed.insert(0);
+		changed.insert(5000);
+		changed.insert(7);
+		changed.clear();
+		CHECK(changed.is_empty());
+		CHECK(changed.has(0) == false);
+		CHECK(changed.has(5000) == false);
+		CHECK(changed.has(7) == false);
+
+		changed.insert(5000);
+		CHECK(changed.size() == 1);
+		CHECK(changed.has(5000));
+		CHECK(changed.has(7) == false);
+	}
+
+	changed.clear();
+	CHECK(changed.is_empty());
+
 	// Remove the `EntityID` 1 as soon as possible.
 	{
 		changed.insert(0);
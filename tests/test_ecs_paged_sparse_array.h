@@ -0,0 +1,78 @@
+#ifndef TEST_PAGED_SPARSE_ARRAY_H
+#define TEST_PAGED_SPARSE_ARRAY_H
+
+#include "../storage/dense_vector.h"
+#include "../storage/paged_sparse_array.h"
+
+#include "tests/test_macros.h"
+
+namespace godex_ecs_paged_sparse_array_tests {
+
+TEST_CASE("[PagedSparseArray] Set and unset.") {
+	PagedSparseArray array;
+
+	CHECK(array.get_allocated_page_count() == 0);
+	CHECK(array.has(0) == false);
+	CHECK(array.get(0) == UINT32_MAX);
+	CHECK(array.get(10000000) == UINT32_MAX);
+
+	// Unset never allocates.
+	array.unset(5000000);
+	CHECK(array.get_allocated_page_count() == 0);
+
+	// A big index allocates only its own page.
+	array.set(5000000, 0);
+	CHECK(array.get_allocated_page_count() == 1);
+	CHECK(array.has(5000000));
+	CHECK(array.get(5000000) == 0);
+	CHECK(array.has(4999999) == false);
+	CHECK(array.has(0) == false);
+
+	array.set(1, 42);
+	CHECK(array.get_allocated_page_count() == 2);
+	CHECK(array.get(1) == 42);
+
+	array.unset(5000000);
+	CHECK(array.has(5000000) == false);
+	CHECK(array.get(1) == 42);
+
+	// The copy doesn't share the pages.
+	PagedSparseArray copy = array;
+	copy.set(1, 7);
+	CHECK(array.get(1) == 42);
+	CHECK(copy.get(1) == 7);
+
+	array.clear();
+	CHECK(array.has(1) == false);
+	CHECK(array.get_allocated_page_count() == 2);
+
+	array.reset();
+	CHECK(array.get_allocated_page_count() == 0);
+	CHECK(array.has(1) == false);
+}
+
+TEST_CASE("[PagedSparseArray] DenseVector with a big EntityID.") {
+	DenseVector<int> vector;
+
+	const EntityID big(3000000, 0);
+	vector.insert(big, 1);
+	vector.insert(EntityID(2, 0), 2);
+
+	CHECK(vector.has(big));
+	CHECK(vector.has(EntityID(2, 0)));
+	CHECK(vector.has(EntityID(3, 0)) == false);
+	CHECK(vector.get(big) == 1);
+	CHECK(vector.get(EntityID(2, 0)) == 2);
+
+	vector.remove(big);
+	CHECK(vector.has(big) == false);
+	CHECK(vector.get(EntityID(2, 0)) == 2);
+	CHECK(vector.get_entities().size() == 1);
+
+	vector.clear();
+	CHECK(vector.has(EntityID(2, 0)) == false);
+	CHECK(vector.get_entities().size() == 0);
+}
+} // namespace godex_ecs_paged_sparse_array_tests
+
+#endif
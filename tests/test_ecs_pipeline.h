@@ -6,6 +6,7 @@
 #include "../ecs.h"
 #include "../modules/godot/components/transform_component.h"
 #include "../pipeline/pipeline.h"
+#include "../pipeline/pipeline_profiler.h"
 #include "../systems/dynamic_system.h"
 
 class PipelineTestDatabag1 : public godex::Databag {
@@ -47,6 +48,9 @@ void system_with_storage(Storage<TransformComponent> *p_storage) {
 void sub_dispatcher_system_test(World *p_world, Pipeline *p_pipeline) {
 }
 
+void system_with_world(World *p_world) {
+}
+
 TEST_CASE("[Modules][ECS] Test pipeline build.") {
 	ECS::register_databag<PipelineTestDatabag1>();
 	ECS::register_databag<PipelineTestDatabag2>();
@@ -162,6 +166,81 @@ TEST_CASE("[Modules][ECS] Test pipeline get_systems_dependencies from a dispatch
 	// Make sure the component storage is correctly fetched from the world.
 	CHECK(info.mutable_components_storage.find(TransformComponent::get_component_id()) != nullptr);
 }
+
+TEST_CASE("[Modules][ECS] Test pipeline stages.") {
+	Pipeline pipeline;
+
+	// These don't conflict, so they run together in the first stage.
+	const uint32_t databag_system = pipeline.add_system(system_with_databag);
+	const uint32_t immutable_databag_system = pipeline.add_system(system_with_immutable_databag);
+	const uint32_t component_system = pipeline.add_system(system_with_component);
+	const uint32_t immutable_component_system = pipeline.add_system(system_with_immutable_component);
+
+	// Mutable access to the `TransformComponent`: second stage.
+	const uint32_t storage_system = pipeline.add_system(system_with_storage);
+
+	// The `World` can access anything: it takes a stage alone.
+	const uint32_t world_system = pipeline.add_system(system_with_world);
+
+	// Nothing conflicts, but it can't run before the `World` system.
+	const uint32_t last_system = pipeline.add_system(system_with_databag);
+
+	pipeline.build();
+
+	CHECK(pipeline.get_stage_count() == 4);
+	CHECK(pipeline.get_system_stage(databag_system) == 0);
+	CHECK(pipeline.get_system_stage(immutable_databag_system) == 0);
+	CHECK(pipeline.get_system_stage(component_system) == 0);
+	CHECK(pipeline.get_system_stage(immutable_component_system) == 0);
+	CHECK(pipeline.get_system_stage(storage_system) == 1);
+	CHECK(pipeline.get_system_stage(world_system) == 2);
+	CHECK(pipeline.get_system_stage(last_system) == 3);
+
+	World world;
+	pipeline.prepare(&world);
+	pipeline.dispatch(&world);
+}
+
+TEST_CASE("[Modules][ECS] Test pipeline profiler.") {
+	Pipeline pipeline;
+	pipeline.add_system(system_with_component);
+	pipeline.add_system(system_with_immutable_component);
+	pipeline.add_system(system_with_storage);
+	pipeline.build();
+
+	World world;
+	for (uint32_t i = 0; i < 10; i += 1) {
+		world.create_entity().with(PipelineTestComponent1());
+	}
+	pipeline.prepare(&world);
+
+	PipelineProfiler &profiler = world.create_databag<PipelineProfiler>();
+	profiler.set_capacity(2);
+
+	// Disabled: nothing is recorded.
+	pipeline.dispatch(&world);
+	CHECK(profiler.get_frame_count() == 0);
+
+	profiler.set_enabled(true);
+	for (uint32_t i = 0; i < 3; i += 1) {
+		pipeline.dispatch(&world);
+	}
+
+	// Only the last frames are kept.
+	CHECK(profiler.get_frame_count() == 2);
+
+	const PipelineProfiler::Frame &frame = profiler.get_last_frame();
+	CHECK(frame.systems.size() == 3);
+	CHECK(frame.systems[0].name == StringName("system_with_component"));
+	CHECK(frame.systems[0].stage == 0);
+	CHECK(frame.systems[0].entities == 10);
+	CHECK(frame.systems[2].name == StringName("system_with_storage"));
+	CHECK(frame.systems[2].stage == 1);
+
+	const String trace = profiler.get_chrome_trace();
+	CHECK(trace.begins_with("{\"traceEvents\":["));
+	CHECK(trace.find("\"name\":\"system_with_storage\"") != -1);
+}
 } // namespace godex_tests_pipeline
 
 #endif // TEST_ECS_PIPELINE_H
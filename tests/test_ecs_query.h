@@ -5,10 +5,12 @@
 
 #include "../components/dynamic_component.h"
 #include "../ecs.h"
+#include "../iterators/cached_query.h"
 #include "../iterators/dynamic_query.h"
 #include "../modules/godot/components/transform_component.h"
 #include "../storage/batch_storage.h"
 #include "../world/world.h"
+#include <atomic>
 
 struct TagQueryTestComponent {
 	COMPONENT(TagQueryTestComponent, DenseVectorStorage)
@@ -19,6 +21,15 @@ struct TagA {
 	COMPONENT(TagA, DenseVectorStorage)
 };
 
+struct ChunkQueryTestComponent {
+	COMPONENT(ChunkQueryTestComponent, DenseVectorStorage)
+
+	int value = 0;
+
+	ChunkQueryTestComponent(int p_value) :
+			value(p_value) {}
+};
+
 struct TagB {
 	COMPONENT(TagB, DenseVectorStorage)
 };
@@ -1693,6 +1704,311 @@ TEST_CASE("[Modules][ECS] Test static query count.") {
 	}
 }
 
+TEST_CASE("[Modules][ECS] Test static query concrete storage.") {
+	CHECK((std::is_same<component_storage_class<ChunkQueryTestComponent>::type, DenseVectorStorage<ChunkQueryTestComponent>>::value));
+
+	World world;
+	for (uint32_t i = 0; i < 10; i += 1) {
+		world.create_entity().with(ChunkQueryTestComponent(i));
+	}
+
+	// The storage type is known, so it's used without virtual calls.
+	QueryStorage<0, const ChunkQueryTestComponent> storage(&world);
+	CHECK(storage.concrete_storage != nullptr);
+
+	int sum = 0;
+	Query<const ChunkQueryTestComponent> query(&world);
+	for (auto [component] : query) {
+		sum += component->value;
+	}
+	CHECK(sum == 45);
+}
+
+TEST_CASE("[Modules][ECS] Test static query par_for_each.") {
+	World world;
+
+	for (uint32_t i = 0; i < 10000; i += 1) {
+		const EntityBuilder &entity = world
+											  .create_entity()
+											  .with(TransformComponent(Transform(Basis(), Vector3(1.0, 0.0, 0.0))));
+		if (i % 2 == 0) {
+			entity.with(TagQueryTestComponent());
+		}
+	}
+
+	{
+		std::atomic<uint32_t> count(0);
+		Query<EntityID, const TransformComponent, Not<const TagQueryTestComponent>> query(&world);
+		query.par_for_each([&count](QueryResultTuple<EntityID, const TransformComponent, Not<const TagQueryTestComponent>> p_result) {
+			auto [entity, transform, tag] = p_result;
+			CRASH_COND(transform == nullptr);
+			CRASH_COND(tag != nullptr);
+			CRASH_COND(uint32_t(entity) % 2 == 0);
+			count.fetch_add(uint32_t(transform->transform.origin.x), std::memory_order_relaxed);
+		},
+				64);
+		CHECK(count.load() == 5000);
+	}
+
+	{
+		// Fetch mutably: the changes are still tracked.
+		world.get_storage<TransformComponent>()->set_tracing_change(true);
+
+		Query<TransformComponent, const TagQueryTestComponent> query(&world);
+		query.par_for_each([](QueryResultTuple<TransformComponent, const TagQueryTestComponent> p_result) {
+			auto [transform, tag] = p_result;
+			transform->transform.origin.x = 2.0;
+		},
+				64);
+
+		Query<EntityID, Changed<const TransformComponent>> changed_query(&world);
+		CHECK(changed_query.count() == 5000);
+		for (auto [entity, transform] : changed_query) {
+			CHECK(uint32_t(entity) % 2 == 0);
+			CHECK(transform->transform.origin.x == 2.0);
+		}
+
+		// The worker threads take the ticks of the calling `System`: the
+		// changes done before its last run are not seen.
+		const SystemTicks previous_ticks = StorageBase::set_system_ticks({ 1000, 999 });
+		std::atomic<uint32_t> count(0);
+		changed_query.par_for_each([&count](QueryResultTuple<EntityID, Changed<const TransformComponent>> p_result) {
+			count.fetch_add(1, std::memory_order_relaxed);
+		},
+				64);
+		CHECK(count.load() == 0);
+		StorageBase::set_system_ticks(previous_ticks);
+
+		world.get_storage<TransformComponent>()->set_tracing_change(false);
+	}
+
+	{
+		// Make sure the query is executed even when it fits a single range.
+		uint32_t count = 0;
+		Query<const TransformComponent, const TagQueryTestComponent> query(&world);
+		query.par_for_each([&count](QueryResultTuple<const TransformComponent, const TagQueryTestComponent> p_result) {
+			count += 1;
+		},
+				20000);
+		CHECK(count == 5000);
+	}
+}
+
+TEST_CASE("[Modules][ECS] Test static query chunks.") {
+	ECS::register_component<ChunkQueryTestComponent>();
+
+	World world;
+
+	for (uint32_t i = 0; i < 1000; i += 1) {
+		const EntityBuilder &entity = world
+											  .create_entity()
+											  .with(ChunkQueryTestComponent(i));
+		if (i % 2 == 0) {
+			entity.with(TagQueryTestComponent());
+		}
+	}
+
+	{
+		// A single dense storage is iterated as a single chunk.
+		world.get_storage<ChunkQueryTestComponent>()->set_tracing_change(true);
+
+		uint32_t chunks = 0;
+		Query<EntityID, ChunkQueryTestComponent> query(&world);
+		for (auto chunk : query.chunks()) {
+			auto [entities, components] = chunk.spans;
+			CHECK(chunk.count == 1000);
+			for (uint32_t i = 0; i < chunk.count; i += 1) {
+				CHECK(components[i].value == int(entities[i]));
+				components[i].value *= 2;
+			}
+			chunks += 1;
+		}
+		CHECK(chunks == 1);
+
+		// The changes are tracked.
+		Query<EntityID, Changed<const ChunkQueryTestComponent>> changed_query(&world);
+		CHECK(changed_query.count() == 1000);
+		for (auto [entity, component] : changed_query) {
+			CHECK(component->value == int(entity) * 2);
+		}
+
+		world.get_storage<ChunkQueryTestComponent>()->set_tracing_change(false);
+	}
+
+	{
+		// The `GLOBAL` space is fetched one `Entity` per chunk.
+		uint32_t chunks = 0;
+		Query<EntityID, const ChunkQueryTestComponent> query(&world);
+		query.space(GLOBAL);
+		for (auto chunk : query.chunks()) {
+			auto [entities, components] = chunk.spans;
+			CHECK(chunk.count == 1);
+			CHECK(components[0].value == int(entities[0]) * 2);
+			chunks += 1;
+		}
+		CHECK(chunks == 1000);
+	}
+
+	{
+		// Not aligned storages, fallback to one `Entity` per chunk.
+		uint32_t count = 0;
+		Query<EntityID, const ChunkQueryTestComponent, const TagQueryTestComponent> query(&world);
+		for (auto chunk : query.chunks()) {
+			auto [entities, components, tags] = chunk.spans;
+			CHECK(chunk.count == 1);
+			CHECK(uint32_t(entities[0]) % 2 == 0);
+			CHECK(components[0].value == int(entities[0]) * 2);
+			CHECK(tags != nullptr);
+			count += chunk.count;
+		}
+		CHECK(count == 500);
+	}
+}
+
+TEST_CASE("[Modules][ECS] Test static query owning group.") {
+	World world;
+
+	Dictionary group;
+	group["group"] = "test_group";
+	world.storages_config[ChunkQueryTestComponent::get_class_static()] = group;
+	world.storages_config[TagQueryTestComponent::get_class_static()] = group;
+
+	LocalVector<EntityID> entities;
+	for (uint32_t i = 0; i < 100; i += 1) {
+		const EntityBuilder &entity = world
+											  .create_entity()
+											  .with(ChunkQueryTestComponent(i));
+		if (i % 3 == 0) {
+			entity.with(TagQueryTestComponent());
+		}
+		entities.push_back(entity);
+	}
+
+	const GroupStorageBase *storage = dynamic_cast<const GroupStorageBase *>(world.get_storage(ChunkQueryTestComponent::get_component_id()));
+	REQUIRE(storage != nullptr);
+	REQUIRE(storage->get_group() != nullptr);
+	CHECK(storage->get_group()->get_size() == 34);
+
+	// Remove some components, the group is kept partitioned.
+	world.remove_component<TagQueryTestComponent>(entities[0]);
+	world.remove_component<ChunkQueryTestComponent>(entities[3]);
+	world.remove_component<ChunkQueryTestComponent>(entities[4]);
+	world.add_component(entities[1], TagQueryTestComponent());
+	CHECK(storage->get_group()->get_size() == 33);
+
+	{
+		// The group prefix is iterated without checking the storages.
+		uint32_t count = 0;
+		Query<EntityID, ChunkQueryTestComponent, const TagQueryTestComponent> query(&world);
+		for (auto [entity, component, tag] : query) {
+			CHECK((uint32_t(entity) % 3 == 0 || uint32_t(entity) == 1));
+			CHECK(component->value == int(entity));
+			CHECK(tag != nullptr);
+			count += 1;
+		}
+		CHECK(count == 33);
+	}
+
+	{
+		// And fetched as a single chunk.
+		uint32_t chunks = 0;
+		Query<EntityID, const TagQueryTestComponent, const ChunkQueryTestComponent> query(&world);
+		for (auto chunk : query.chunks()) {
+			auto [chunk_entities, tags, components] = chunk.spans;
+			CHECK(chunk.count == 33);
+			for (uint32_t i = 0; i < chunk.count; i += 1) {
+				CHECK(components[i].value == int(chunk_entities[i]));
+			}
+			chunks += 1;
+		}
+		CHECK(chunks == 1);
+	}
+
+	{
+		// A subset of the group is iterated as usual.
+		Query<const ChunkQueryTestComponent> query(&world);
+		CHECK(query.count() == 98);
+	}
+}
+
+TEST_CASE("[Modules][ECS] Test cached query.") {
+	World world;
+
+	LocalVector<EntityID> entities;
+	for (uint32_t i = 0; i < 100; i += 1) {
+		const EntityBuilder &entity = world
+											  .create_entity()
+											  .with(ChunkQueryTestComponent(i));
+		if (i % 3 == 0) {
+			entity.with(TagQueryTestComponent());
+		}
+		entities.push_back(entity);
+	}
+
+	{
+		CachedQuery<EntityID, const ChunkQueryTestComponent, Not<TagQueryTestComponent>> query(&world);
+		CHECK(query.count() == 66);
+	}
+
+	// Structural changes, the cache re-checks just these `Entities`.
+	world.add_component(entities[1], TagQueryTestComponent());
+	world.remove_component<ChunkQueryTestComponent>(entities[2]);
+	world.remove_component<TagQueryTestComponent>(entities[3]);
+	world.destroy_entity(entities[4]);
+	world.flush();
+	const EntityID added = world.create_entity().with(ChunkQueryTestComponent(1000));
+
+	{
+		uint32_t count = 0;
+		CachedQuery<EntityID, const ChunkQueryTestComponent, Not<TagQueryTestComponent>> query(&world);
+		for (auto [entity, component, tag] : query) {
+			CHECK(world.is_entity_alive(entity));
+			CHECK(component != nullptr);
+			CHECK(query.has(entity));
+			count += 1;
+		}
+		CHECK(count == 65);
+		CHECK(query.count() == 65);
+		CHECK(query.has(added));
+		CHECK(query.has(entities[1]) == false);
+		CHECK(query.has(entities[3]));
+	}
+
+	// Clearing a storage rebuilds the cache.
+	world.get_storage<TagQueryTestComponent>()->clear();
+	{
+		CachedQuery<EntityID, const ChunkQueryTestComponent, Not<TagQueryTestComponent>> query(&world);
+		CHECK(query.count() == 99);
+	}
+
+	// The same `Entities` of the `Query`.
+	{
+		world.add_component(entities[5], TagQueryTestComponent());
+		world.add_component(entities[6], TagQueryTestComponent());
+		world.flush();
+
+		CachedQuery<EntityID, const ChunkQueryTestComponent, Not<TagQueryTestComponent>> cached(&world);
+		Query<EntityID, const ChunkQueryTestComponent, Not<TagQueryTestComponent>> query(&world);
+		CHECK(cached.count() == query.count());
+		for (auto [entity, component, tag] : query) {
+			CHECK(cached.has(entity));
+		}
+	}
+
+	// Within a `Pipeline` stage the cache is updated once, so the other
+	// `System`s of the stage can iterate it meanwhile.
+	{
+		QueryCache cache;
+		CHECK(cache.needs_update(0));
+		cache.set_updated_stage(5);
+		CHECK(cache.needs_update(5) == false);
+		CHECK(cache.needs_update(6));
+		CHECK(cache.needs_update(0));
+		cache.invalidate();
+		CHECK(cache.needs_update(5));
+	}
+}
+
 TEST_CASE("[Modules][ECS] Test static query Any filter.") {
 	World world;
 
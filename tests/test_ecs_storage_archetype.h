@@ -0,0 +1,137 @@
+#ifndef TEST_ECS_STORAGE_ARCHETYPE_H
+#define TEST_ECS_STORAGE_ARCHETYPE_H
+
+#include "tests/test_macros.h"
+
+#include "../components/component.h"
+#include "../ecs.h"
+#include "../iterators/query.h"
+#include "../storage/archetype_storage.h"
+#include "../world/world.h"
+
+namespace godex_storage_archetype_tests {
+
+struct ArchetypeTestPosition {
+	COMPONENT(ArchetypeTestPosition, ArchetypeStorage)
+
+	int x = 0;
+
+	ArchetypeTestPosition(int p_x) :
+			x(p_x) {}
+};
+
+struct ArchetypeTestVelocity {
+	COMPONENT(ArchetypeTestVelocity, ArchetypeStorage)
+
+	int x = 0;
+
+	ArchetypeTestVelocity(int p_x) :
+			x(p_x) {}
+};
+
+TEST_CASE("[Modules][ECS] Test archetype storage insert and remove.") {
+	ECS::register_component<ArchetypeTestPosition>();
+	ECS::register_component<ArchetypeTestVelocity>();
+
+	World world;
+
+	for (uint32_t i = 0; i < 1000; i += 1) {
+		const EntityBuilder &entity = world.create_entity().with(ArchetypeTestPosition(i));
+		if (i % 3 == 0) {
+			entity.with(ArchetypeTestVelocity(i * 2));
+		}
+	}
+
+	Storage<ArchetypeTestPosition> *positions = world.get_storage<ArchetypeTestPosition>();
+	Storage<ArchetypeTestVelocity> *velocities = world.get_storage<ArchetypeTestVelocity>();
+
+	CHECK(positions->get_stored_entities().count == 1000);
+	CHECK(velocities->get_stored_entities().count == 334);
+
+	// Make sure moving the entities between archetypes keeps the data.
+	for (uint32_t i = 0; i < 1000; i += 1) {
+		CHECK(positions->get(i)->x == int(i));
+		if (i % 3 == 0) {
+			CHECK(velocities->has(i));
+			CHECK(velocities->get(i)->x == int(i * 2));
+		} else {
+			CHECK(velocities->has(i) == false);
+		}
+	}
+
+	// Remove the `Position` from half the entities.
+	for (uint32_t i = 0; i < 1000; i += 2) {
+		positions->remove(i);
+	}
+
+	CHECK(positions->get_stored_entities().count == 500);
+	CHECK(velocities->get_stored_entities().count == 334);
+
+	for (uint32_t i = 0; i < 1000; i += 1) {
+		CHECK(positions->has(i) == (i % 2 == 1));
+		if (i % 2 == 1) {
+			CHECK(positions->get(i)->x == int(i));
+		}
+		if (i % 3 == 0) {
+			CHECK(velocities->get(i)->x == int(i * 2));
+		}
+	}
+
+	// Update an existing component.
+	positions->insert(1, ArchetypeTestPosition(-1));
+	CHECK(positions->get(1)->x == -1);
+	CHECK(positions->get_stored_entities().count == 500);
+
+	{
+		// The query iterates the entities having both.
+		Query<EntityID, const ArchetypeTestPosition, ArchetypeTestVelocity> query(&world);
+		uint32_t count = 0;
+		for (auto [entity, position, velocity] : query) {
+			CHECK(uint32_t(entity) % 6 == 3);
+			CHECK(position->x == int(entity));
+			CHECK(velocity->x == int(entity) * 2);
+			count += 1;
+		}
+		CHECK(count == 167);
+	}
+
+	velocities->clear();
+	CHECK(velocities->get_stored_entities().count == 0);
+	CHECK(positions->get_stored_entities().count == 500);
+	CHECK(positions->get(3)->x == 3);
+}
+TEST_CASE("[Modules][ECS] Test archetype storage query chunks.") {
+	World world;
+
+	for (uint32_t i = 0; i < 5000; i += 1) {
+		const EntityBuilder &entity = world.create_entity().with(ArchetypeTestPosition(0));
+		if (i % 2 == 0) {
+			entity.with(ArchetypeTestVelocity(i));
+		}
+	}
+
+	uint32_t chunks = 0;
+	uint32_t count = 0;
+	Query<EntityID, ArchetypeTestPosition, const ArchetypeTestVelocity> query(&world);
+	for (auto chunk : query.chunks()) {
+		auto [entities, positions, velocities] = chunk.spans;
+		CHECK(chunk.count > 0);
+		for (uint32_t i = 0; i < chunk.count; i += 1) {
+			CHECK(velocities[i].x == int(entities[i]));
+			positions[i].x += velocities[i].x;
+		}
+		chunks += 1;
+		count += chunk.count;
+	}
+	// The entities are packed in chunks, not fetched one by one.
+	CHECK(chunks < 10);
+	CHECK(count == 2500);
+
+	Storage<ArchetypeTestPosition> *positions = world.get_storage<ArchetypeTestPosition>();
+	for (uint32_t i = 0; i < 5000; i += 1) {
+		CHECK(positions->get(i)->x == (i % 2 == 0 ? int(i) : 0));
+	}
+}
+} // namespace godex_storage_archetype_tests
+
+#endif // TEST_ECS_STORAGE_ARCHETYPE_H
@@ -5,6 +5,7 @@
 
 #include "../components/component.h"
 #include "../storage/dense_vector_storage.h"
+#include "../world/world.h"
 
 namespace godex_storage_dense_vector_tests {
 
@@ -112,6 +113,27 @@ TEST_CASE("[Modules][ECS] Test dense storage insert and remove.") {
 		}
 	}
 }
+
+TEST_CASE("[Modules][ECS] Test dense storage change ticks rebase.") {
+	std::atomic<uint32_t> counter(1);
+	DenseVectorStorage<TestInt> storage;
+	storage.set_change_tick_counter(&counter);
+	storage.set_tracing_change(true);
+
+	// A big `Entity` index doesn't allocate all the ticks before it.
+	const EntityID entity(5000000);
+	storage.insert(entity, 1);
+	CHECK(storage.is_changed(entity));
+
+	// The counter advanced a lot: the change is too old and it's forgotten.
+	counter.store((1 << 30) + 100);
+	storage.rebase_change_ticks(counter.load() - World::CHANGE_TICK_MAX_AGE);
+	CHECK(storage.is_changed(entity) == false);
+
+	// The new changes are still detected.
+	storage.get(entity)->number = 2;
+	CHECK(storage.is_changed(entity));
+}
 } // namespace godex_storage_dense_vector_tests
 
 #endif
@@ -16,8 +16,10 @@ TEST_CASE("[Modules][ECS] Test Hierarchy.") {
 	// This is used to make sure the hierarchy is properly created even when
 	// bad data is used.
 	Child malformed_child(3);
-	malformed_child.first_child = 1;
-	malformed_child.next = 1;
+	malformed_child.child_index = 1;
+	malformed_child.children_offset = 1;
+	malformed_child.children_count = 10;
+	malformed_child.children_capacity = 10;
 
 	// The hierarchy is as follows:
 	// Entity 0
@@ -220,6 +222,55 @@ TEST_CASE("[Modules][ECS] Test Hierarchy.") {
 	}
 }
 
+TEST_CASE("[Modules][ECS] Test Hierarchy contiguous children.") {
+	Hierarchy hierarchy;
+	const Hierarchy &hierarchy_const = hierarchy;
+
+	// Interleave the children of two parents, so their ranges are moved at
+	// the end of the pool while growing.
+	for (uint32_t i = 0; i < 50; i += 1) {
+		hierarchy.insert(10 + i, Child(0));
+		hierarchy.insert(100 + i, Child(1));
+	}
+	CHECK(hierarchy_const.get(0)->children_count == 50);
+	CHECK(hierarchy_const.get(1)->children_count == 50);
+
+	// Remove some children from the middle.
+	hierarchy.remove(10);
+	hierarchy.remove(30);
+	hierarchy.insert(100, Child(0));
+
+	CHECK(hierarchy_const.get(0)->children_count == 49);
+	CHECK(hierarchy_const.get(1)->children_count == 49);
+
+	uint32_t count = 0;
+	hierarchy.for_each_child(0, [&](EntityID p_entity, const Child &p_child) -> bool {
+		const bool valid = p_entity == EntityID(100) || (uint32_t(p_entity) >= 11 && uint32_t(p_entity) < 60 && uint32_t(p_entity) != 30);
+		CHECK(valid);
+		CHECK(p_child.parent == EntityID(0));
+		count += 1;
+		return true;
+	});
+	CHECK(count == 49);
+
+	count = 0;
+	hierarchy.for_each_child(1, [&](EntityID p_entity, const Child &p_child) -> bool {
+		const bool valid = uint32_t(p_entity) >= 101 && uint32_t(p_entity) < 150;
+		CHECK(valid);
+		CHECK(p_child.parent == EntityID(1));
+		count += 1;
+		return true;
+	});
+	CHECK(count == 49);
+
+	// Removing the parent removes the children without further relationships.
+	hierarchy.remove(1);
+	CHECK(hierarchy_const.has(1) == false);
+	CHECK(hierarchy_const.has(101) == false);
+	CHECK(hierarchy_const.has(100));
+	CHECK(hierarchy_const.get(100)->parent == EntityID(0));
+}
+
 TEST_CASE("[Modules][ECS] Test HierarchicalStorage.") {
 	Hierarchy hierarchy;
 
@@ -341,6 +392,141 @@ TEST_CASE("[Modules][ECS] Test HierarchicalStorage.") {
 		CHECK(entities.count == 5);
 	}
 }
+
+TEST_CASE("[Modules][ECS] Test HierarchicalStorage depth sorted propagation.") {
+	Hierarchy hierarchy;
+
+	HierarchicalStorage<TransformComponent> transform_storage;
+	transform_storage.set_propagation(HierarchicalStorageBase::PROPAGATION_DEPTH_SORTED);
+	hierarchy.add_sub_storage(&transform_storage);
+
+	// A binary tree, inserted children first so the storages are not sorted
+	// by depth.
+	const uint32_t count = 63;
+	for (uint32_t i = count - 1; i > 0; i -= 1) {
+		hierarchy.insert(i, Child((i - 1) / 2));
+	}
+	for (uint32_t i = count; i > 0; i -= 1) {
+		transform_storage.insert(i - 1, TransformComponent(Transform(Basis(), Vector3(1, 0, 0))));
+	}
+
+	auto depth = [](uint32_t p_entity) -> uint32_t {
+		uint32_t d = 0;
+		while (p_entity != 0) {
+			p_entity = (p_entity - 1) / 2;
+			d += 1;
+		}
+		return d;
+	};
+
+	// Move the root: all the tree is updated with a single pass.
+	transform_storage.get(0)->transform.origin.x = 2.0;
+	transform_storage.flush_changes();
+
+	for (uint32_t i = 0; i < count; i += 1) {
+		const TransformComponent *global = std::as_const(transform_storage).get(i, Space::GLOBAL);
+		CHECK(ABS(global->transform.origin.x - (2.0 + depth(i))) <= CMP_EPSILON);
+	}
+
+	// Set the global of a child, its local is updated.
+	transform_storage.get(5, Space::GLOBAL)->transform.origin.x = 10.0;
+	transform_storage.flush_changes();
+	CHECK(ABS(std::as_const(transform_storage).get(5)->transform.origin.x - 7.0) <= CMP_EPSILON);
+	// The children of `Entity 5` (11 and 12) follow it.
+	CHECK(ABS(std::as_const(transform_storage).get(11, Space::GLOBAL)->transform.origin.x - 11.0) <= CMP_EPSILON);
+	CHECK(ABS(std::as_const(transform_storage).get(12, Space::GLOBAL)->transform.origin.x - 11.0) <= CMP_EPSILON);
+
+	// Change the hierarchy: `Entity 2` becomes root.
+	hierarchy.insert(2, Child(EntityID()));
+	hierarchy.flush_hierarchy_changes();
+	CHECK(ABS(std::as_const(transform_storage).get(2, Space::GLOBAL)->transform.origin.x - 1.0) <= CMP_EPSILON);
+	CHECK(ABS(std::as_const(transform_storage).get(5, Space::GLOBAL)->transform.origin.x - 8.0) <= CMP_EPSILON);
+	CHECK(ABS(std::as_const(transform_storage).get(1, Space::GLOBAL)->transform.origin.x - 3.0) <= CMP_EPSILON);
+}
+
+TEST_CASE("[Modules][ECS] Test HierarchicalStorage parallel flush.") {
+	Hierarchy hierarchy;
+
+	HierarchicalStorage<TransformComponent> transform_storage;
+	transform_storage.set_parallel_flush(true);
+	hierarchy.add_sub_storage(&transform_storage);
+
+	// 20 characters, each one is a chain of 10 `Entities`.
+	const uint32_t characters = 20;
+	const uint32_t bones = 10;
+	for (uint32_t c = 0; c < characters; c += 1) {
+		for (uint32_t b = 1; b < bones; b += 1) {
+			hierarchy.insert(c * bones + b, Child(c * bones + b - 1));
+		}
+	}
+	for (uint32_t i = 0; i < characters * bones; i += 1) {
+		transform_storage.insert(i, TransformComponent(Transform(Basis(), Vector3(1, 0, 0))));
+	}
+
+	// Move all the characters, and some bones too: each subtree is processed
+	// once, from its topmost dirty `Entity`.
+	for (uint32_t c = 0; c < characters; c += 1) {
+		transform_storage.get(c * bones + 5)->transform.origin.x = 2.0;
+		transform_storage.get(c * bones)->transform.origin.x = c;
+	}
+	transform_storage.flush_changes();
+
+	for (uint32_t c = 0; c < characters; c += 1) {
+		for (uint32_t b = 0; b < bones; b += 1) {
+			const TransformComponent *global = std::as_const(transform_storage).get(c * bones + b, Space::GLOBAL);
+			const real_t expected = real_t(c) + b + (b >= 5 ? 1.0 : 0.0);
+			CHECK(ABS(global->transform.origin.x - expected) <= CMP_EPSILON);
+		}
+	}
+}
+
+TEST_CASE("[Modules][ECS] Test HierarchicalStorage lazy global.") {
+	Hierarchy hierarchy;
+
+	HierarchicalStorage<TransformComponent> transform_storage;
+	transform_storage.set_lazy_global(true);
+	hierarchy.add_sub_storage(&transform_storage);
+
+	// Entity 0
+	// |- Entity 1
+	// |   |- Entity 2
+	hierarchy.insert(1, Child(0));
+	hierarchy.insert(2, Child(1));
+	for (uint32_t i = 0; i < 3; i += 1) {
+		transform_storage.insert(i, TransformComponent(Transform(Basis(), Vector3(1, 0, 0))));
+	}
+
+	// The writer `System` releases the storage: nothing is propagated yet,
+	// not even when a global is read.
+	transform_storage.get(0)->transform.origin.x = 5.0;
+	transform_storage.on_system_release();
+	CHECK(transform_storage.is_lazy_pending());
+	CHECK(ABS(std::as_const(transform_storage).get(2)->transform.origin.x - 1.0) <= CMP_EPSILON);
+	CHECK(ABS(std::as_const(transform_storage).get(2, Space::GLOBAL)->transform.origin.x - 3.0) <= CMP_EPSILON);
+
+	// The `Pipeline` propagates the changes before the next stage that takes
+	// the storage, while no `System` runs.
+	transform_storage.on_stage_read();
+	CHECK(transform_storage.is_lazy_pending() == false);
+	CHECK(ABS(std::as_const(transform_storage).get(2, Space::GLOBAL)->transform.origin.x - 7.0) <= CMP_EPSILON);
+	CHECK(ABS(std::as_const(transform_storage).get(1, Space::GLOBAL)->transform.origin.x - 6.0) <= CMP_EPSILON);
+
+	// The hierarchy changes are propagated lazily too.
+	hierarchy.remove(2);
+	hierarchy.flush_hierarchy_changes();
+	transform_storage.on_stage_read();
+	CHECK(ABS(std::as_const(transform_storage).get(2, Space::GLOBAL)->transform.origin.x - 1.0) <= CMP_EPSILON);
+
+	// Writing the global of the synced storage.
+	transform_storage.get(1)->transform.origin.x = 2.0;
+	transform_storage.flush_changes();
+	TransformComponent *global = transform_storage.get(1, Space::GLOBAL);
+	CHECK(ABS(global->transform.origin.x - 7.0) <= CMP_EPSILON);
+	global->transform.origin.x = 10.0;
+	transform_storage.flush_changes();
+	CHECK(ABS(std::as_const(transform_storage).get(1)->transform.origin.x - 5.0) <= CMP_EPSILON);
+}
+
 // TODO test hierarchy sorting?
 } // namespace godex_storage_hierarchical_tests
 
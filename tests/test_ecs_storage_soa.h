@@ -0,0 +1,81 @@
+#ifndef TEST_ECS_STORAGE_SOA_H
+#define TEST_ECS_STORAGE_SOA_H
+
+#include "tests/test_macros.h"
+
+#include "../components/component.h"
+#include "../storage/soa_storage.h"
+#include <cstddef>
+
+namespace godex_storage_soa_tests {
+
+struct TestBoid {
+	COMPONENT(TestBoid, SoAStorage)
+
+public:
+	Vector3 position;
+	Vector3 velocity;
+
+	TestBoid(const Vector3 &p_position, const Vector3 &p_velocity) :
+			position(p_position), velocity(p_velocity) {}
+};
+
+TEST_CASE("[Modules][ECS] Test SoA storage insert and remove.") {
+	SoAStorage<TestBoid> storage;
+	CHECK(SoAStorage<TestBoid>::FIELDS == 6);
+
+	for (uint32_t i = 0; i < 100; i += 1) {
+		storage.insert(i, TestBoid(Vector3(i, 0, 0), Vector3(1, 2, 3)));
+	}
+	CHECK(storage.size() == 100);
+
+	storage.remove(0);
+	storage.remove(50);
+	storage.remove(1000);
+	CHECK(storage.size() == 98);
+	CHECK(storage.has(0) == false);
+	CHECK(storage.has(50) == false);
+	CHECK(storage.has(99));
+
+	const TestBoid boid = storage.get_component(99);
+	CHECK(boid.position == Vector3(99, 0, 0));
+	CHECK(boid.velocity == Vector3(1, 2, 3));
+
+	storage.set_component(99, TestBoid(Vector3(5, 6, 7), Vector3()));
+	CHECK(storage.get_component(99).position == Vector3(5, 6, 7));
+
+	storage.clear();
+	CHECK(storage.size() == 0);
+	CHECK(storage.has(1) == false);
+}
+
+TEST_CASE("[Modules][ECS] Test SoA storage fields.") {
+	SoAStorage<TestBoid> storage;
+	for (uint32_t i = 0; i < 37; i += 1) {
+		storage.insert(i, TestBoid(Vector3(i, 0, 0), Vector3(1, 2, 3)));
+	}
+
+	const uint32_t px_field = SoAStorage<TestBoid>::field_of(offsetof(TestBoid, position.x));
+	const uint32_t vx_field = SoAStorage<TestBoid>::field_of(offsetof(TestBoid, velocity.x));
+	CHECK(px_field == 0);
+	CHECK(vx_field == 3);
+
+	// Each field is aligned, so it can be processed with SIMD.
+	for (uint32_t f = 0; f < SoAStorage<TestBoid>::FIELDS; f += 1) {
+		CHECK(uintptr_t(storage.get_field(f)) % SoAStorage<TestBoid>::SOA_ALIGNMENT == 0);
+	}
+
+	real_t *px = storage.get_field(px_field);
+	const real_t *vx = storage.get_field(vx_field);
+	for (uint32_t i = 0; i < storage.size(); i += 1) {
+		px[i] += vx[i] * 2.0;
+	}
+
+	const EntityID *entities = storage.get_entities();
+	for (uint32_t i = 0; i < storage.size(); i += 1) {
+		CHECK(storage.get_component(entities[i]).position.x == real_t(uint32_t(entities[i]) + 2));
+	}
+}
+} // namespace godex_storage_soa_tests
+
+#endif // TEST_ECS_STORAGE_SOA_H
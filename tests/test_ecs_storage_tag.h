@@ -0,0 +1,106 @@
+#ifndef TEST_TAG_STORAGE_H
+#define TEST_TAG_STORAGE_H
+
+#include "../components/component.h"
+#include "../ecs.h"
+#include "../iterators/query.h"
+#include "../storage/dense_vector_storage.h"
+#include "../storage/tag_storage.h"
+#include "../world/world.h"
+
+#include "tests/test_macros.h"
+
+struct TagStorageTestTag {
+	COMPONENT_TAG(TagStorageTestTag)
+	static void _bind_methods() {}
+};
+
+struct TagStorageTestValue {
+	COMPONENT(TagStorageTestValue, DenseVectorStorage)
+
+	int value = 0;
+
+	TagStorageTestValue(int p_value) :
+			value(p_value) {}
+};
+
+namespace godex_ecs_tag_storage_tests {
+
+TEST_CASE("[TagStorage] Insert, remove and clear.") {
+	TagStorage<TagStorageTestTag> storage;
+
+	for (uint32_t i = 0; i < 200; i += 2) {
+		storage.insert(i, TagStorageTestTag());
+	}
+	// Inserting twice doesn't duplicate it.
+	storage.insert(0, TagStorageTestTag());
+
+	CHECK(storage.get_stored_entities().count == 100);
+	CHECK(storage.has(0));
+	CHECK(storage.has(1) == false);
+	CHECK(storage.has(198));
+	CHECK(storage.has(100000) == false);
+
+	// All the entities share the same instance.
+	CHECK(storage.get(0) == storage.get(2));
+
+	storage.remove(0);
+	storage.remove(50);
+	storage.remove(1);
+	CHECK(storage.get_stored_entities().count == 98);
+	CHECK(storage.has(0) == false);
+	CHECK(storage.has(50) == false);
+	CHECK(storage.has(2));
+
+	const EntitiesBuffer stored = storage.get_stored_entities();
+	for (uint32_t i = 0; i < stored.count; i += 1) {
+		CHECK(storage.has(stored.entities[i]));
+		CHECK(uint32_t(stored.entities[i]) % 2 == 0);
+	}
+
+	storage.clear();
+	CHECK(storage.get_stored_entities().count == 0);
+	CHECK(storage.has(2) == false);
+
+	storage.insert(2, TagStorageTestTag());
+	CHECK(storage.has(2));
+	CHECK(storage.has(4) == false);
+}
+
+TEST_CASE("[TagStorage] Query with tags.") {
+	ECS::register_component<TagStorageTestTag>();
+	ECS::register_component<TagStorageTestValue>();
+
+	World world;
+	for (uint32_t i = 0; i < 30; i += 1) {
+		const EntityBuilder &entity = world.create_entity().with(TagStorageTestValue(i));
+		if (i % 3 == 0) {
+			entity.with(TagStorageTestTag());
+		}
+	}
+
+	{
+		uint32_t count = 0;
+		Query<EntityID, const TagStorageTestValue, const TagStorageTestTag> query(&world);
+		for (auto [entity, value, tag] : query) {
+			CHECK(value->value % 3 == 0);
+			CHECK(tag != nullptr);
+			count += 1;
+		}
+		CHECK(count == 10);
+	}
+
+	{
+		uint32_t count = 0;
+		Query<const TagStorageTestValue, Not<TagStorageTestTag>> query(&world);
+		for (auto [value, tag] : query) {
+			CHECK(value->value % 3 != 0);
+			CHECK(tag == nullptr);
+			count += 1;
+		}
+		CHECK(count == 20);
+	}
+}
+} // namespace godex_ecs_tag_storage_tests
+
+#endif
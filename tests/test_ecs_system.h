@@ -540,6 +540,200 @@ TEST_CASE("[Modules][ECS] Test create and remove Entity from Systems.") {
 	}
 }
 
+void test_command_spawn_system(CommandBuffer &p_commands) {
+	for (uint32_t i = 0; i < 3; i += 1) {
+		const EntityID entity = p_commands.spawn();
+		p_commands.insert(entity, TransformComponent());
+		p_commands.insert(entity, Test1Component(i));
+	}
+}
+
+void test_command_edit_system(CommandBuffer &p_commands, Query<EntityID, const Test1Component> &p_query) {
+	for (auto [entity, component] : p_query) {
+		p_commands.remove<Test1Component>(entity);
+		if (component->a == 0) {
+			p_commands.despawn(entity);
+		}
+	}
+}
+
+TEST_CASE("[Modules][ECS] Test system command buffer.") {
+	World world;
+
+	Pipeline pipeline;
+	pipeline.add_system(test_command_spawn_system);
+	pipeline.add_system(test_command_edit_system);
+	pipeline.build();
+	pipeline.prepare(&world);
+
+	// The structural changes are deferred, so these `System`s don't conflict.
+	CHECK(pipeline.get_stage_count() == 1);
+
+	pipeline.dispatch(&world);
+	world.flush();
+
+	{
+		// The spawned `Entities` are created at the end of the stage, so the
+		// `test_command_edit_system` didn't see them.
+		Query<const TransformComponent, const Test1Component> query(&world);
+		CHECK(query.count() == 3);
+	}
+
+	pipeline.dispatch(&world);
+
+	{
+		Query<const TransformComponent> transforms(&world);
+		CHECK(transforms.count() == 6);
+		// Removed from the old ones, but added to the new ones.
+		Query<const Test1Component> components(&world);
+		CHECK(components.count() == 3);
+	}
+
+	world.flush();
+
+	{
+		// The despawned `Entity` is destroyed by the `flush`.
+		Query<const TransformComponent> transforms(&world);
+		CHECK(transforms.count() == 5);
+	}
+}
+
+void test_command_spawn_tag_system(CommandBuffer &p_commands) {
+	p_commands.insert(p_commands.spawn(), TagTestComponent());
+}
+
+TEST_CASE("[Modules][ECS] Test command buffer creates the missing storages.") {
+	World world;
+
+	Pipeline pipeline;
+	pipeline.add_system(test_command_spawn_tag_system);
+	pipeline.build();
+	pipeline.prepare(&world);
+
+	// No `System` declares the `TagTestComponent`, so its storage doesn't
+	// exist yet: it's created when the commands are applied.
+	CHECK(world.get_storage<TagTestComponent>() == nullptr);
+
+	pipeline.dispatch(&world);
+
+	Query<const TagTestComponent> query(&world);
+	CHECK(query.count() == 1);
+}
+
+TEST_CASE("[Modules][ECS] Test command buffer with the world commands.") {
+	World world;
+
+	Pipeline pipeline;
+	const uint32_t spawn_system = pipeline.add_system(test_command_spawn_tag_system);
+	const uint32_t spawn_system_2 = pipeline.add_system(test_command_spawn_tag_system);
+	const uint32_t create_system = pipeline.add_system(test_add_entity_system);
+	pipeline.build();
+	pipeline.prepare(&world);
+
+	// The `CommandBuffer`s reserve the IDs together, while `create_entity`
+	// alters the reserved IDs: so it runs in another stage.
+	CHECK(pipeline.get_system_stage(spawn_system) == pipeline.get_system_stage(spawn_system_2));
+	CHECK(pipeline.get_system_stage(spawn_system) != pipeline.get_system_stage(create_system));
+
+	for (uint32_t i = 0; i < 3; i += 1) {
+		pipeline.dispatch(&world);
+		world.flush();
+	}
+
+	Query<const TagTestComponent> tags(&world);
+	CHECK(tags.count() == 6);
+	Query<const TransformComponent> transforms(&world);
+	CHECK(transforms.count() == 9);
+
+	// Each `Entity` got its own ID.
+	Query<EntityID, const TagTestComponent> tagged(&world);
+	for (auto [entity, tag] : tagged) {
+		CHECK(world.get_storage<TransformComponent>()->has(entity) == false);
+	}
+}
+
+TEST_CASE("[Modules][ECS] Test command buffer applies the commands in order.") {
+	World world;
+	const EntityID entity_1 = world.create_entity().with(Test1Component(1));
+	const EntityID entity_2 = world.create_entity();
+
+	CommandBuffer &commands = CommandBuffer::fetch(&world);
+	commands.remove<Test1Component>(entity_1);
+	commands.insert(entity_1, Test1Component(2));
+	commands.insert(entity_2, Test1Component(3));
+	commands.remove<Test1Component>(entity_2);
+	world.flush();
+
+	const Storage<const Test1Component> *storage = world.get_storage<const Test1Component>();
+	CHECK(storage->has(entity_1));
+	CHECK(storage->get(entity_1)->a == 2);
+	CHECK(storage->has(entity_2) == false);
+}
+
+struct TestChangeTicksDatabag : public godex::Databag {
+	DATABAG(TestChangeTicksDatabag)
+
+	/// The amount of frames the writer `System` changes the components.
+	int writes = 1;
+	/// The changed components seen by the reader `System` in the last frame.
+	int seen = 0;
+};
+
+void test_change_reader_system(TestChangeTicksDatabag *p_databag, Query<Changed<const Test1Component>> &p_query) {
+	p_databag->seen = p_query.count();
+}
+
+void test_change_writer_system(TestChangeTicksDatabag *p_databag, Query<Test1Component> &p_query) {
+	if (p_databag->writes <= 0) {
+		return;
+	}
+	p_databag->writes -= 1;
+	for (auto [component] : p_query) {
+		component->a += 1;
+	}
+}
+
+TEST_CASE("[Modules][ECS] Test system change ticks.") {
+	ECS::register_databag<TestChangeTicksDatabag>();
+
+	World world;
+	world.create_databag<TestChangeTicksDatabag>();
+	const EntityID entity = world.create_entity().with(Test1Component(0));
+	world.create_entity().with(Test1Component(0));
+
+	// The reader runs before the writer, in another stage.
+	Pipeline pipeline;
+	pipeline.add_system(test_change_reader_system);
+	pipeline.add_system(test_change_writer_system);
+	pipeline.build();
+	pipeline.prepare(&world);
+	CHECK(pipeline.get_stage_count() == 2);
+
+	TestChangeTicksDatabag *databag = world.get_databag<TestChangeTicksDatabag>();
+
+	// The components created before `prepare` are changed, so the first
+	// execution sees them.
+	pipeline.dispatch(&world);
+	CHECK(databag->seen == 2);
+
+	// The writer changed the components after the reader, in the previous
+	// frame: the reader still sees them.
+	pipeline.dispatch(&world);
+	CHECK(databag->seen == 2);
+
+	// Already seen, and nothing changed since.
+	pipeline.dispatch(&world);
+	CHECK(databag->seen == 0);
+
+	// The changes done outside the `Pipeline` are seen by the next dispatch.
+	world.get_storage<Test1Component>()->get(entity)->a = 5;
+	pipeline.dispatch(&world);
+	CHECK(databag->seen == 1);
+
+	pipeline.dispatch(&world);
+	CHECK(databag->seen == 0);
+}
+
 TEST_CASE("[Modules][ECS] Test system and hierarchy.") {
 	World world;
 
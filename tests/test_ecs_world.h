@@ -16,6 +16,15 @@ public:
 	int a = 10;
 };
 
+struct SpawnBatchTestComponent {
+	COMPONENT(SpawnBatchTestComponent, DenseVectorStorage)
+
+	int value = 0;
+
+	SpawnBatchTestComponent(int p_value) :
+			value(p_value) {}
+};
+
 namespace godex_tests_world {
 
 TEST_CASE("[Modules][ECS] Test world has self databag.") {
@@ -45,6 +54,197 @@ TEST_CASE("[Modules][ECS] Test world") {
 	CHECK((entity_1_transform_component.transform.origin - transform_from_storage->transform.origin).length() < CMP_EPSILON);
 }
 
+TEST_CASE("[Modules][ECS] Test world recycles the destroyed entities.") {
+	World world;
+
+	LocalVector<EntityID> entities;
+	for (uint32_t i = 0; i < 2000; i += 1) {
+		entities.push_back(world.create_entity().with(TransformComponent()));
+	}
+
+	for (uint32_t i = 0; i < entities.size(); i += 1) {
+		CHECK(world.is_entity_alive(entities[i]));
+		world.get_commands().destroy_deferred(entities[i]);
+	}
+	// Destroying twice the same `Entity` is fine.
+	world.get_commands().destroy_deferred(entities[0]);
+	world.flush();
+
+	for (uint32_t i = 0; i < entities.size(); i += 1) {
+		CHECK(world.is_entity_alive(entities[i]) == false);
+	}
+
+	// The oldest destroyed index is recycled, with a new generation.
+	const EntityID recycled = world.create_entity();
+	CHECK(recycled.get_index() == entities[0].get_index());
+	CHECK(recycled.get_generation() == entities[0].get_generation() + 1);
+	CHECK((recycled == entities[0]) == false);
+	CHECK(world.is_entity_alive(recycled));
+	CHECK(world.is_entity_alive(entities[0]) == false);
+
+	// The new `Entity` doesn't have the components of the old one.
+	CHECK(world.get_storage<TransformComponent>()->has(recycled) == false);
+
+	// The stale `EntityID` can't destroy the new `Entity`.
+	ERR_PRINT_OFF;
+	world.destroy_entity(entities[0]);
+	ERR_PRINT_ON;
+	CHECK(world.is_entity_alive(recycled));
+
+	// The deferred spawns recycle the destroyed indices too: the `Entity`
+	// exists once the commands are applied.
+	const EntityID deferred = CommandBuffer::fetch(&world).spawn();
+	CHECK(deferred.get_index() == entities[1].get_index());
+	CHECK(deferred.get_generation() == entities[1].get_generation() + 1);
+	CHECK(world.is_entity_alive(deferred) == false);
+	world.flush();
+	CHECK(world.is_entity_alive(deferred));
+}
+
+TEST_CASE("[Modules][ECS] Test world destroys the entities in batch.") {
+	World world;
+
+	const EntityID parent = world.create_entity().with(TransformComponent());
+
+	LocalVector<EntityID> entities;
+	for (uint32_t i = 0; i < 100; i += 1) {
+		const EntityBuilder &entity = world.create_entity().with(TransformComponent());
+		if (i % 2 == 0) {
+			entity.with(Child(parent));
+		}
+		entities.push_back(entity);
+	}
+
+	world.get_commands().destroy_deferred(parent);
+	for (uint32_t i = 0; i < entities.size(); i += 3) {
+		world.get_commands().destroy_deferred(entities[i]);
+	}
+	world.flush();
+
+	const Storage<const TransformComponent> *transforms = world.get_storage<const TransformComponent>();
+	const Storage<const Child> *hierarchy = world.get_storage<const Child>();
+
+	CHECK(world.is_entity_alive(parent) == false);
+	CHECK(transforms->has(parent) == false);
+	CHECK(hierarchy->has(parent) == false);
+
+	for (uint32_t i = 0; i < entities.size(); i += 1) {
+		const bool destroyed = i % 3 == 0;
+		CHECK(world.is_entity_alive(entities[i]) == !destroyed);
+		CHECK(transforms->has(entities[i]) == !destroyed);
+		// The parent is destroyed, so the children are unlinked.
+		CHECK(hierarchy->has(entities[i]) == false);
+	}
+
+	// The remaining entities can still be destroyed one by one.
+	world.destroy_entity(entities[1]);
+	CHECK(transforms->has(entities[1]) == false);
+	CHECK(transforms->has(entities[2]));
+}
+
+TEST_CASE("[Modules][ECS] Test world spawn batch.") {
+	ECS::register_component<SpawnBatchTestComponent>();
+
+	World world;
+
+	const EntityID single = world.create_entity().with(SpawnBatchTestComponent(-1));
+
+	const EntityRange range = world.spawn_batch(
+			5000,
+			SpawnBatchTestComponent(7),
+			TransformComponent(Transform(Basis(), Vector3(1.0, 0.0, 0.0))));
+
+	CHECK(range.count == 5000);
+	CHECK(range[0].get_index() == single.get_index() + 1);
+
+	const Storage<const SpawnBatchTestComponent> *components = world.get_storage<const SpawnBatchTestComponent>();
+	const Storage<const TransformComponent> *transforms = world.get_storage<const TransformComponent>();
+
+	CHECK(components->get_stored_entities().count == 5001);
+	CHECK(components->get(single)->value == -1);
+	for (uint32_t i = 0; i < range.count; i += 1) {
+		CHECK(world.is_entity_alive(range[i]));
+		CHECK(range[i].get_index() == range.first.get_index() + i);
+		CHECK(components->get(range[i])->value == 7);
+		CHECK(transforms->get(range[i])->transform.origin.x == 1.0);
+	}
+
+	// The spawned entities are the same of the others.
+	world.destroy_entity(range[10]);
+	CHECK(components->has(range[10]) == false);
+	CHECK(transforms->has(range[10]) == false);
+	CHECK(components->get(range[11])->value == 7);
+
+	const EntityID after = world.create_entity();
+	CHECK(after.get_index() == range[range.count - 1].get_index() + 1);
+
+	// The batches never recycle the destroyed IDs, the single `Entities` do.
+	for (uint32_t i = 1000; i < 3000; i += 1) {
+		world.destroy_entity(range[i]);
+	}
+	const EntityRange next_range = world.spawn_batch(10, SpawnBatchTestComponent(8));
+	CHECK(next_range[0].get_index() == after.get_index() + 1);
+	const EntityID recycled = world.create_entity();
+	CHECK(recycled.get_index() == range[10].get_index());
+}
+
+TEST_CASE("[Modules][ECS] Test world sorts the storages by entity.") {
+	if (SpawnBatchTestComponent::get_component_id() == godex::COMPONENT_NONE) {
+		ECS::register_component<SpawnBatchTestComponent>();
+	}
+
+	World world;
+
+	LocalVector<EntityID> entities;
+	for (uint32_t i = 0; i < 20; i += 1) {
+		entities.push_back(world.create_entity().with(SpawnBatchTestComponent(i)));
+	}
+
+	// The removal swaps the last component into the hole.
+	world.remove_component<SpawnBatchTestComponent>(entities[2]);
+	world.remove_component<SpawnBatchTestComponent>(entities[5]);
+
+	StorageBase *storage = world.get_storage(SpawnBatchTestComponent::get_component_id());
+	CHECK(storage->needs_sort());
+
+	// Disabled by default.
+	world.flush();
+	CHECK(storage->needs_sort());
+
+	// The sort is incremental: each `flush` moves at most 4 components.
+	world.set_sort_budget(4);
+	world.flush();
+	CHECK(storage->needs_sort());
+	uint32_t flushes = 1;
+	while (storage->needs_sort() && flushes < 100) {
+		world.flush();
+		flushes += 1;
+	}
+	CHECK(storage->needs_sort() == false);
+	CHECK(flushes > 5);
+
+	const EntitiesBuffer stored = storage->get_stored_entities();
+	CHECK(stored.count == 18);
+	for (uint32_t i = 1; i < stored.count; i += 1) {
+		CHECK(stored.entities[i - 1].get_index() < stored.entities[i].get_index());
+	}
+
+	const Storage<const SpawnBatchTestComponent> *components = world.get_storage<const SpawnBatchTestComponent>();
+	for (uint32_t i = 0; i < entities.size(); i += 1) {
+		if (i == 2 || i == 5) {
+			CHECK(components->has(entities[i]) == false);
+		} else {
+			CHECK(components->get(entities[i])->value == int(i));
+		}
+	}
+
+	// Disabled.
+	world.set_sort_budget(0);
+	world.remove_component<SpawnBatchTestComponent>(entities[0]);
+	world.flush();
+	CHECK(storage->needs_sort());
+}
+
 TEST_CASE("[Modules][ECS] Test storage script component") {
 	LocalVector<ScriptProperty> props;
 	props.push_back({ PropertyInfo(Variant::INT, "variable_1"), 1 });
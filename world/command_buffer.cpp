@@ -0,0 +1,67 @@
+#include "command_buffer.h"
+
+#include "world.h"
+
+thread_local CommandBuffer *CommandBuffer::current = nullptr;
+
+CommandBuffer::~CommandBuffer() {
+	for (uint32_t i = 0; i < inserts.size(); i += 1) {
+		if (inserts[i] != nullptr) {
+			memdelete(inserts[i]);
+		}
+	}
+}
+
+EntityID CommandBuffer::spawn() {
+	ERR_FAIL_COND_V_MSG(world == nullptr, EntityID(), "This `CommandBuffer` is not bound to any `World`.");
+	has_spawns = true;
+	return world->get_commands().reserve_entity();
+}
+
+void CommandBuffer::despawn(EntityID p_entity) {
+	despawns.push_back(p_entity);
+}
+
+void CommandBuffer::remove(EntityID p_entity, godex::component_id p_component_id) {
+	touch(p_component_id);
+	record(p_component_id, false, removals[p_component_id].size());
+	removals[p_component_id].push_back(p_entity);
+}
+
+bool CommandBuffer::is_empty() const {
+	return has_spawns == false && runs.size() == 0 && despawns.size() == 0;
+}
+
+CommandBuffer *CommandBuffer::set_current(CommandBuffer *p_buffer) {
+	CommandBuffer *previous = current;
+	current = p_buffer;
+	return previous;
+}
+
+CommandBuffer &CommandBuffer::fetch(World *p_world) {
+	CommandBuffer *buffer = current != nullptr ? current : &p_world->command_buffer;
+	buffer->world = p_world;
+	return *buffer;
+}
+
+void CommandBuffer::touch(godex::component_id p_component_id) {
+	if (p_component_id >= inserts.size()) {
+		const uint32_t old_size = inserts.size();
+		inserts.resize(p_component_id + 1);
+		removals.resize(p_component_id + 1);
+		for (uint32_t i = old_size; i < inserts.size(); i += 1) {
+			inserts[i] = nullptr;
+		}
+	}
+}
+
+void CommandBuffer::record(godex::component_id p_component_id, bool p_insert, uint32_t p_position) {
+	if (runs.size() > 0) {
+		Run &last = runs[runs.size() - 1];
+		if (last.component == p_component_id && last.insert == p_insert) {
+			last.count += 1;
+			return;
+		}
+	}
+	runs.push_back({ p_component_id, p_insert, p_position, 1 });
+}
@@ -0,0 +1,137 @@
+#pragma once
+
+#include "../ecs_types.h"
+#include "../storage/storage.h"
+#include "core/templates/local_vector.h"
+
+class World;
+
+/// Records the structural changes of a `System`: spawn and despawn
+/// `Entities`, insert and remove components. The changes are not applied
+/// immediately, so the storages are never altered while a `Query` is
+/// iterating them; the `Pipeline` applies them at the end of the stage.
+///
+/// Each `System` has its own `CommandBuffer`, so the `System`s of the same
+/// stage record their commands in parallel without any lock.
+/// ```
+/// void shoot_system(CommandBuffer &p_commands, Query<const Gun> &p_query) {
+/// 	for (auto [gun] : p_query) {
+/// 		EntityID bullet = p_commands.spawn();
+/// 		p_commands.insert(bullet, Bullet());
+/// 	}
+/// }
+/// ```
+///
+/// The commands are applied in the same order they are recorded: the
+/// consecutive commands for the same storage are applied at once, so the
+/// storage receives all these components together. The spawned `Entities`
+/// exist before any other command is applied, the despawned `Entities` are
+/// destroyed by the next `World::flush`.
+class CommandBuffer {
+	friend class World;
+
+	/// The components to insert into a storage, stored with their type so
+	/// the insertion doesn't need any conversion.
+	struct InsertQueueBase {
+		LocalVector<EntityID> entities;
+
+		virtual ~InsertQueueBase() {}
+		virtual void apply(StorageBase *p_storage, uint32_t p_from, uint32_t p_count) = 0;
+		virtual void clear() = 0;
+	};
+
+	template <class C>
+	struct InsertQueue : public InsertQueueBase {
+		LocalVector<C> data;
+
+		virtual void apply(StorageBase *p_storage, uint32_t p_from, uint32_t p_count) override {
+			static_cast<Storage<C> *>(p_storage)->insert_list(entities.ptr() + p_from, data.ptr() + p_from, p_count);
+		}
+
+		virtual void clear() override {
+			entities.clear();
+			data.clear();
+		}
+	};
+
+	/// Consecutive commands of the same kind, for the same component: the
+	/// elements `from` to `from + count` of its insert or removal queue.
+	struct Run {
+		godex::component_id component;
+		bool insert;
+		uint32_t from;
+		uint32_t count;
+	};
+
+	/// Indexed by component ID, kept across the dispatches to reuse the memory.
+	LocalVector<InsertQueueBase *> inserts;
+	LocalVector<LocalVector<EntityID>> removals;
+	/// The recorded commands, in order. `World::apply_commands` walks them,
+	/// so it doesn't check all the storages.
+	LocalVector<Run> runs;
+
+	LocalVector<EntityID> despawns;
+	bool has_spawns = false;
+
+	/// The `World` the commands are recorded for, used to reserve the IDs of
+	/// the spawned `Entities`.
+	World *world = nullptr;
+
+	/// The `CommandBuffer` of the `System` running on this thread.
+	static thread_local CommandBuffer *current;
+
+public:
+	CommandBuffer() = default;
+	CommandBuffer(const CommandBuffer &) = delete;
+	CommandBuffer &operator=(const CommandBuffer &) = delete;
+	~CommandBuffer();
+
+	/// Returns the new `Entity` ID: it can be used right away with the other
+	/// commands, but the `Entity` exists only once the buffer is applied.
+	EntityID spawn();
+
+	/// Destroys the `Entity`, with all its components.
+	void despawn(EntityID p_entity);
+
+	/// Adds the component to the `Entity`, or sets it if already exists.
+	template <class C>
+	void insert(EntityID p_entity, const C &p_data);
+
+	/// Removes the component from the `Entity`, if it has it.
+	template <class C>
+	void remove(EntityID p_entity) {
+		remove(p_entity, C::get_component_id());
+	}
+	void remove(EntityID p_entity, godex::component_id p_component_id);
+
+	/// Returns `true` if there is nothing to apply.
+	bool is_empty() const;
+
+	/// Set by the `Pipeline` while the `System` owning this buffer runs;
+	/// returns the previous buffer.
+	static CommandBuffer *set_current(CommandBuffer *p_buffer);
+
+	/// Returns the buffer of the running `System`: when the `System` is not
+	/// executed by a `Pipeline`, returns the `World` buffer, applied by
+	/// `World::flush`.
+	static CommandBuffer &fetch(World *p_world);
+
+private:
+	/// Makes room for the queues of this component.
+	void touch(godex::component_id p_component_id);
+	/// Appends the command to the last run, or starts a new one.
+	void record(godex::component_id p_component_id, bool p_insert, uint32_t p_position);
+};
+
+template <class C>
+void CommandBuffer::insert(EntityID p_entity, const C &p_data) {
+	const godex::component_id id = C::get_component_id();
+	touch(id);
+	if (inserts[id] == nullptr) {
+		inserts[id] = memnew(InsertQueue<C>);
+	}
+	InsertQueue<C> *queue = static_cast<InsertQueue<C> *>(inserts[id]);
+	record(id, true, queue->entities.size());
+	queue->entities.push_back(p_entity);
+	queue->data.push_back(p_data);
+}
@@ -2,7 +2,10 @@
 #include "world.h"
 
 #include "../ecs.h"
+#include "../iterators/query_cache.h"
+#include "../storage/archetype_storage.h"
 #include "../storage/hierarchical_storage.h"
+#include "../storage/storage_group.h"
 
 EntityBuilder::EntityBuilder(World *p_world) :
 		world(p_world) {
@@ -21,16 +24,112 @@ const EntityBuilder &EntityBuilder::with(uint32_t p_component_id, godex::SID p_s
 void WorldCommands::_bind_methods() {
 	add_method("create_entity", &WorldCommands::create_entity);
 	add_method("destroy_deferred", &WorldCommands::destroy_deferred);
+	add_method("is_entity_alive", &WorldCommands::is_entity_alive);
 }
 
 EntityID WorldCommands::create_entity() {
-	return entity_register++;
+	const EntityID entity = reserve_entity();
+	materialize_reserved();
+	return entity;
+}
+
+EntityRange WorldCommands::create_entities(uint32_t p_count) {
+	EntityRange range;
+
+	const uint32_t start = next_index.fetch_add(p_count, std::memory_order_relaxed);
+	if (unlikely(uint64_t(start) + p_count > EntityID::MAX_INDEX + 1)) {
+		next_index.fetch_sub(p_count, std::memory_order_relaxed);
+		ERR_FAIL_V_MSG(range, "It's not possible to create more contiguous `Entities`: the batches never recycle the destroyed IDs.");
+	}
+	materialize_reserved();
+
+	range.first = EntityID(start, 0);
+	range.count = p_count;
+	return range;
+}
+
+EntityID WorldCommands::reserve_entity() {
+	uint32_t index;
+	if (recycle_index(MIN_FREE_INDICES, index)) {
+		return EntityID(index, generations[index]);
+	}
+
+	index = next_index.fetch_add(1, std::memory_order_relaxed);
+	if (unlikely(index > EntityID::MAX_INDEX)) {
+		next_index.fetch_sub(1, std::memory_order_relaxed);
+		// No more never used indices: recycle any released one.
+		if (recycle_index(0, index)) {
+			return EntityID(index, generations[index]);
+		}
+		ERR_FAIL_V_MSG(EntityID(), "It's not possible to create more `Entities`.");
+	}
+	return EntityID(index, 0);
+}
+
+bool WorldCommands::recycle_index(uint32_t p_keep, uint32_t &r_index) {
+	// `free_indices` is altered only when no `System` runs, so it's safe to
+	// read it here: just the head is contended.
+	uint32_t head = free_head.load(std::memory_order_relaxed);
+	while ((free_indices.size() - head) > p_keep) {
+		if (free_head.compare_exchange_weak(head, head + 1, std::memory_order_relaxed)) {
+			r_index = free_indices[head];
+			return true;
+		}
+	}
+	return false;
 }
 
 void WorldCommands::destroy_deferred(EntityID p_entity) {
 	garbage_list.push_back(p_entity);
 }
 
+bool WorldCommands::is_entity_alive(EntityID p_entity) const {
+	const uint32_t index = p_entity;
+	return index < alive.size() &&
+		   alive[index] &&
+		   generations[index] == p_entity.get_generation();
+}
+
+void WorldCommands::release_entity(EntityID p_entity) {
+	const uint32_t index = p_entity;
+	alive[index] = false;
+	// The next `Entity` using this index has a new generation, so the
+	// `EntityID`s pointing to this one are detected as stale.
+	generations[index] += 1;
+	free_indices.push_back(index);
+}
+
+void WorldCommands::materialize_reserved() {
+	// The recycled indices.
+	const uint32_t head = free_head.load(std::memory_order_relaxed);
+	for (uint32_t i = free_materialized; i < head; i += 1) {
+		alive[free_indices[i]] = true;
+	}
+	free_materialized = head;
+
+	if (head > 0 && head * 2 >= free_indices.size()) {
+		// Drop the consumed indices, so the list doesn't grow forever.
+		const uint32_t remaining = free_indices.size() - head;
+		memmove(free_indices.ptr(), free_indices.ptr() + head, sizeof(uint32_t) * remaining);
+		free_indices.resize(remaining);
+		free_head.store(0, std::memory_order_relaxed);
+		free_materialized = 0;
+	}
+
+	// The never used indices.
+	const uint32_t start = generations.size();
+	const uint32_t end = next_index.load(std::memory_order_relaxed);
+	if (start >= end) {
+		return;
+	}
+	generations.resize(end);
+	alive.resize(end);
+	for (uint32_t i = start; i < end; i += 1) {
+		generations[i] = 0;
+		alive[i] = true;
+	}
+}
+
 void World::_bind_methods() {
 }
 
@@ -46,15 +145,29 @@ World::World() {
 	databags[WorldCommands::get_databag_id()] = &commands;
 	databags[World::get_databag_id()] = this;
 
+	entity_signatures.setup(ECS::get_components_count());
+
 	create_storage<Child>();
 }
 
 World::~World() {
+	for (uint32_t i = 0; i < groups.size(); i += 1) {
+		memdelete(groups[i]);
+	}
+	for (uint32_t i = 0; i < query_caches.size(); i += 1) {
+		if (query_caches[i]) {
+			memdelete(query_caches[i]);
+		}
+	}
 	for (uint32_t i = 0; i < storages.size(); i += 1) {
 		if (storages[i]) {
 			delete storages[i];
 		}
 	}
+	if (archetype_table) {
+		memdelete(archetype_table);
+		archetype_table = nullptr;
+	}
 	for (uint32_t i = 0; i < databags.size(); i += 1) {
 		if (i == World::get_databag_id() || i == WorldCommands::get_databag_id()) {
 			// This is automatic memory.
@@ -76,14 +189,32 @@ const EntityBuilder &World::create_entity() {
 }
 
 void World::destroy_entity(EntityID p_entity) {
+	ERR_FAIL_COND_MSG(commands.is_entity_alive(p_entity) == false, "The Entity " + itos(p_entity) + " doesn't exist or it's already destroyed.");
+
+	if (archetype_table) {
+		// Removes all the archetype components at once.
+		archetype_table->remove_entity(p_entity);
+	}
+
 	// Removes the components assigned to this entity.
-	for (uint32_t i = 0; i < storages.size(); i += 1) {
-		if (storages[i] != nullptr) {
-			storages[i]->remove(p_entity);
+	entity_signatures.for_each(p_entity, [&](godex::component_id p_component) {
+		if (p_component < storages.size() && storages[p_component] != nullptr) {
+			storages[p_component]->remove_batch(&p_entity, 1);
+		}
+	});
+	for (uint32_t i = 0; i < untracked_storages.size(); i += 1) {
+		if (storages[untracked_storages[i]] != nullptr) {
+			storages[untracked_storages[i]]->remove_batch(&p_entity, 1);
 		}
 	}
+	entity_signatures.clear(p_entity);
+
+	// Now this ID can be reused.
+	commands.release_entity(p_entity);
+}
 
-	// TODO consider to reuse this ID.
+bool World::is_entity_alive(EntityID p_entity) const {
+	return commands.is_entity_alive(p_entity);
 }
 
 WorldCommands &World::get_commands() {
@@ -95,11 +226,178 @@ const WorldCommands &World::get_commands() const {
 }
 
 void World::flush() {
-	// Destroy the `Entities`.
+	apply_commands(command_buffer);
+	destroy_garbage();
+	sort_storages();
+	trim_structural_logs();
+	rebase_change_ticks();
+}
+
+void World::set_sort_budget(uint32_t p_budget) {
+	sort_budget = p_budget;
+}
+
+uint32_t World::get_sort_budget() const {
+	return sort_budget;
+}
+
+void World::destroy_garbage() {
+	// Destroy the `Entities`: first collect the components to remove, so each
+	// storage removes all its components at once.
+	destroyed_entities.clear();
 	for (uint32_t i = 0; i < commands.garbage_list.size(); i += 1) {
-		destroy_entity(commands.garbage_list[i]);
+		const EntityID entity = commands.garbage_list[i];
+		if (commands.is_entity_alive(entity) == false) {
+			// The same `Entity` may be marked for disposal more than once.
+			continue;
+		}
+		commands.release_entity(entity);
+		destroyed_entities.push_back(entity);
+
+		if (archetype_table) {
+			// Removes all the archetype components at once.
+			archetype_table->remove_entity(entity);
+		}
+
+		entity_signatures.for_each(entity, [&](godex::component_id p_component) {
+			if (p_component >= removal_lists.size()) {
+				removal_lists.resize(p_component + 1);
+			}
+			removal_lists[p_component].push_back(entity);
+		});
 	}
 	commands.garbage_list.clear();
+
+	if (destroyed_entities.size() == 0) {
+		return;
+	}
+
+	for (uint32_t i = 0; i < removal_lists.size(); i += 1) {
+		if (removal_lists[i].size() == 0) {
+			continue;
+		}
+		if (i < storages.size() && storages[i] != nullptr) {
+			storages[i]->remove_batch(removal_lists[i].ptr(), removal_lists[i].size());
+		}
+		removal_lists[i].clear();
+	}
+
+	for (uint32_t i = 0; i < untracked_storages.size(); i += 1) {
+		if (storages[untracked_storages[i]] != nullptr) {
+			storages[untracked_storages[i]]->remove_batch(destroyed_entities.ptr(), destroyed_entities.size());
+		}
+	}
+
+	for (uint32_t i = 0; i < destroyed_entities.size(); i += 1) {
+		entity_signatures.clear(destroyed_entities[i]);
+	}
+}
+
+void World::rebase_change_ticks() {
+	const uint32_t counter = change_tick.load(std::memory_order_relaxed);
+	if (counter - change_tick_rebased < CHANGE_TICK_REBASE_PERIOD) {
+		return;
+	}
+	change_tick_rebased = counter;
+	const uint32_t oldest = get_oldest_change_tick();
+	for (uint32_t i = 0; i < storages.size(); i += 1) {
+		if (storages[i]) {
+			storages[i]->rebase_change_ticks(oldest);
+		}
+	}
+}
+
+uint64_t World::get_dispatch_stage() const {
+	return dispatch_stage;
+}
+
+uint32_t World::get_oldest_change_tick() const {
+	return change_tick.load(std::memory_order_relaxed) - CHANGE_TICK_MAX_AGE;
+}
+
+void World::trim_structural_logs() {
+	for (uint32_t i = 0; i < storages.size(); i += 1) {
+		StorageBase *storage = storages[i];
+		if (storage && storage->get_structural_log_end() - storage->get_structural_log_begin() > storage->get_stored_entities().count) {
+			storage->trim_structural_log();
+		}
+	}
+}
+
+QueryCache *World::get_query_cache(uint32_t p_cache_id) {
+	MutexLock lock(query_caches_mutex);
+	if (p_cache_id >= query_caches.size()) {
+		const uint32_t start = query_caches.size();
+		query_caches.resize(p_cache_id + 1);
+		for (uint32_t i = start; i < query_caches.size(); i += 1) {
+			query_caches[i] = nullptr;
+		}
+	}
+	if (query_caches[p_cache_id] == nullptr) {
+		query_caches[p_cache_id] = memnew(QueryCache);
+	}
+	return query_caches[p_cache_id];
+}
+
+void World::sort_storages() {
+	if (sort_budget == 0 || storages.size() == 0) {
+		return;
+	}
+
+	const godex::component_id start = sort_cursor % storages.size();
+	uint32_t budget = sort_budget;
+	for (uint32_t i = 0; i < storages.size() && budget > 0; i += 1) {
+		const godex::component_id id = (start + i) % storages.size();
+		StorageBase *storage = storages[id];
+		if (storage == nullptr || storage->needs_sort() == false) {
+			continue;
+		}
+
+		budget -= MIN(storage->sort_by_entity(budget), budget);
+		// The storage not yet sorted starts the next `flush`, so all the
+		// storages get their turn.
+		sort_cursor = storage->needs_sort() ? id : id + 1;
+	}
+}
+
+void World::apply_commands(CommandBuffer &p_commands) {
+	if (p_commands.has_spawns) {
+		commands.materialize_reserved();
+		p_commands.has_spawns = false;
+	}
+
+	// In the recording order, so `remove` then `insert` leaves the component.
+	for (uint32_t i = 0; i < p_commands.runs.size(); i += 1) {
+		const CommandBuffer::Run &run = p_commands.runs[i];
+		if (run.insert) {
+			// No `System` is running: the storages that no `System` declared
+			// are created here.
+			create_storage_at_sync_point(run.component);
+			StorageBase *storage = get_storage(run.component);
+			ERR_CONTINUE_MSG(storage == nullptr, "The storage of the component " + ECS::get_component_name(run.component) + " can't be created.");
+			p_commands.inserts[run.component]->apply(storage, run.from, run.count);
+		} else {
+			StorageBase *storage = get_storage(run.component);
+			if (storage != nullptr) {
+				storage->remove_batch(p_commands.removals[run.component].ptr() + run.from, run.count);
+			}
+		}
+	}
+
+	for (uint32_t i = 0; i < p_commands.runs.size(); i += 1) {
+		const godex::component_id id = p_commands.runs[i].component;
+		if (p_commands.inserts[id] != nullptr) {
+			p_commands.inserts[id]->clear();
+		}
+		p_commands.removals[id].clear();
+	}
+	p_commands.runs.clear();
+
+	// The `Entities` are destroyed by `flush`, together with the others.
+	for (uint32_t i = 0; i < p_commands.despawns.size(); i += 1) {
+		commands.destroy_deferred(p_commands.despawns[i]);
+	}
+	p_commands.despawns.clear();
 }
 
 void World::add_component(EntityID p_entity, uint32_t p_component_id, const Dictionary &p_data) {
@@ -181,6 +479,10 @@ void World::create_storage(uint32_t p_component_id) {
 		return;
 	}
 
+	create_storage_at_sync_point(p_component_id);
+}
+
+void World::create_storage_at_sync_point(uint32_t p_component_id) {
 	// Using crash because this function is not expected to fail.
 	ERR_FAIL_COND_MSG(ECS::verify_component_id(p_component_id) == false, "The component id " + itos(p_component_id) + " is not registered.");
 
@@ -196,6 +498,15 @@ void World::create_storage(uint32_t p_component_id) {
 	}
 
 	storages[p_component_id] = ECS::create_storage(p_component_id);
+	storages[p_component_id]->set_change_tick_counter(&change_tick);
+
+	// Keep track of the components of each `Entity`, so to not check all the
+	// storages when an `Entity` is destroyed.
+	if (storages[p_component_id]->notifies_entity_signature() && entity_signatures.can_track(p_component_id)) {
+		storages[p_component_id]->set_entity_signatures(&entity_signatures, p_component_id);
+	} else {
+		untracked_storages.push_back(p_component_id);
+	}
 
 	// Automatically set the hierarchy, if this is a HierarchicalStorage.
 	HierarchicalStorageBase *hs = dynamic_cast<HierarchicalStorageBase *>(storages[p_component_id]);
@@ -205,6 +516,15 @@ void World::create_storage(uint32_t p_component_id) {
 		hierarchy->add_sub_storage(hs);
 	}
 
+	// Automatically set the archetype table, if this is an ArchetypeStorage.
+	ArchetypeStorageBase *as = dynamic_cast<ArchetypeStorageBase *>(storages[p_component_id]);
+	if (as) {
+		if (archetype_table == nullptr) {
+			archetype_table = memnew(ArchetypeTable);
+		}
+		as->set_table(archetype_table);
+	}
+
 	// Search the config for this storage.
 	Dictionary config = storages_config.get(
 			ECS::get_component_name(p_component_id),
@@ -218,6 +538,27 @@ void World::create_storage(uint32_t p_component_id) {
 	}
 
 	storages[p_component_id]->configure(config);
+
+	if (config.has("group")) {
+		// This storage is owned by a group: the group partitions it together
+		// with the other storages having the same group name.
+		GroupStorageBase *gs = dynamic_cast<GroupStorageBase *>(storages[p_component_id]);
+		ERR_FAIL_COND_MSG(gs == nullptr, "The storage of the component " + ECS::get_component_name(p_component_id) + " can't be grouped: only the dense storages (like `DenseVectorStorage`) can.");
+
+		const StringName group_name = config["group"];
+		StorageGroup *group = nullptr;
+		for (uint32_t i = 0; i < groups.size(); i += 1) {
+			if (groups[i]->get_name() == group_name) {
+				group = groups[i];
+				break;
+			}
+		}
+		if (group == nullptr) {
+			group = memnew(StorageGroup(group_name));
+			groups.push_back(group);
+		}
+		group->add_member(gs, p_component_id);
+	}
 }
 
 void World::destroy_storage(uint32_t p_component_id) {
@@ -229,8 +570,29 @@ void World::destroy_storage(uint32_t p_component_id) {
 		return;
 	}
 
+	if (storages[p_component_id]->is_structure_shared()) {
+		// The data is stored outside the storage, so make sure to release it.
+		storages[p_component_id]->clear();
+	}
+
+	GroupStorageBase *gs = dynamic_cast<GroupStorageBase *>(storages[p_component_id]);
+	if (gs && gs->get_group()) {
+		gs->get_group()->remove_member(gs);
+	}
+
+	// The `Entities` don't have this component anymore.
+	storages[p_component_id]->notify_removed_all();
+	untracked_storages.erase(p_component_id);
+
 	delete storages[p_component_id];
 	storages[p_component_id] = nullptr;
+
+	// A new storage may take the same address.
+	for (uint32_t i = 0; i < query_caches.size(); i += 1) {
+		if (query_caches[i]) {
+			query_caches[i]->invalidate();
+		}
+	}
 }
 
 void World::create_databag(godex::databag_id p_id) {
@@ -3,11 +3,17 @@
 #include "../databags/databag.h"
 #include "../ecs_types.h"
 #include "../storage/storage.h"
+#include "command_buffer.h"
+#include "core/os/mutex.h"
 #include "core/string/string_name.h"
+#include <atomic>
 #include "core/templates/local_vector.h"
 
 class StorageBase;
 class World;
+class ArchetypeTable;
+class StorageGroup;
+class QueryCache;
 
 namespace godex {
 class Databag;
@@ -51,6 +57,19 @@ public:
 	}
 };
 
+/// A range of contiguous `Entities`, created by `World::spawn_batch`.
+struct EntityRange {
+	EntityID first;
+	uint32_t count = 0;
+
+	EntityID operator[](uint32_t p_index) const {
+#ifdef DEBUG_ENABLED
+		CRASH_COND(p_index >= count);
+#endif
+		return EntityID(first.get_index() + p_index, first.get_generation());
+	}
+};
+
 // TODO make this under godex namespace.
 
 // TODO consider to split this in multiple `Databag`, one for removal and the
@@ -60,8 +79,27 @@ class WorldCommands : public godex::Databag {
 
 	friend class World;
 
-	/// Used to keep tracks of entity IDs.
-	uint32_t entity_register = 0;
+	/// The destroyed indices are recycled only when there are at least this
+	/// amount of free indices: this way the same index is not reused too
+	/// often, and its generation takes longer to wrap around.
+	static constexpr uint32_t MIN_FREE_INDICES = 1024;
+
+	/// The current generation of each `Entity` index.
+	LocalVector<uint8_t> generations;
+	/// `true` when the `Entity` index is in use.
+	LocalVector<bool> alive;
+	/// The destroyed indices, recycled in the same order they are released.
+	LocalVector<uint32_t> free_indices;
+	/// The next index of `free_indices` to recycle. It's atomic so the
+	/// `CommandBuffer`s can recycle the indices while the `System`s run in
+	/// parallel: the recycled indices before it are alive only once
+	/// `materialize_reserved` reaches them (see `free_materialized`).
+	std::atomic<uint32_t> free_head{ 0 };
+	uint32_t free_materialized = 0;
+	/// The next never used index. It's atomic so the `CommandBuffer`s can
+	/// reserve the indices while the `System`s run in parallel: the reserved
+	/// indices are added to `generations` by `materialize_reserved`.
+	std::atomic<uint32_t> next_index{ 0 };
 
 	/// List of `Entity` to destroy.
 	LocalVector<EntityID> garbage_list;
@@ -72,8 +110,35 @@ public:
 	/// Immediately creates a new `Entity`.
 	EntityID create_entity();
 
+	/// Immediately creates `p_count` new `Entities`, with contiguous IDs.
+	/// The destroyed IDs are never contiguous, so they are not recycled by
+	/// this function: it always takes never used indices, that are limited
+	/// to `EntityID::MAX_INDEX`. Use `create_entity` or `reserve_entity` for
+	/// the `Entities` spawned and destroyed continuously.
+	EntityRange create_entities(uint32_t p_count);
+
+	/// Reserves a new `Entity` ID, that exists only after `World::flush` or
+	/// `World::apply_commands`. Unlike `create_entity`, this function is
+	/// thread safe. The destroyed IDs are recycled, as `create_entity` does.
+	EntityID reserve_entity();
+
 	/// Mark this `Entity` for disposal.
 	void destroy_deferred(EntityID p_entity);
+
+	/// Returns `true` if this `Entity` exists: `false` when it was never
+	/// created or it's already destroyed.
+	bool is_entity_alive(EntityID p_entity) const;
+
+private:
+	/// Releases the `Entity` index, so it can be recycled.
+	void release_entity(EntityID p_entity);
+
+	/// Takes the oldest released index, when more than `p_keep` are free.
+	/// Thread safe against the other `reserve_entity`.
+	bool recycle_index(uint32_t p_keep, uint32_t &r_index);
+
+	/// Creates the `Entities` reserved by `reserve_entity`.
+	void materialize_reserved();
 };
 
 // IMPORTANT, when multithreading is implemented, all the `System`s asking for
@@ -82,13 +147,55 @@ class World : public godex::Databag {
 	DATABAG(World)
 
 	friend class Pipeline;
+	friend class CommandBuffer;
 
 	WorldCommands commands;
+	/// Used by the `System`s executed outside a `Pipeline`.
+	CommandBuffer command_buffer;
 	LocalVector<StorageBase *> storages;
 	LocalVector<godex::Databag *> databags;
 	EntityBuilder entity_builder = EntityBuilder(this);
 	bool is_dispatching_in_progress = false;
 
+	/// The change tick counter shared by all the storages: each `System`
+	/// execution takes a new tick, used to detect the changes done since its
+	/// previous execution.
+	std::atomic<uint32_t> change_tick{ 1 };
+
+	/// The `Pipeline` stage in execution, `0` outside a stage. Each stage
+	/// takes a new id from `dispatch_stage_counter`.
+	uint64_t dispatch_stage = 0;
+	uint64_t dispatch_stage_counter = 0;
+	/// The counter value of the last `rebase_change_ticks`.
+	uint32_t change_tick_rebased = 1;
+
+	/// Shared by all the `ArchetypeStorage`s of this world, created on demand.
+	ArchetypeTable *archetype_table = nullptr;
+
+	/// The owning groups declared by the storages config (`group` key).
+	LocalVector<StorageGroup *> groups;
+
+	/// The matches of each `CachedQuery` type, created on demand.
+	LocalVector<QueryCache *> query_caches;
+	Mutex query_caches_mutex;
+
+	/// The components of each `Entity`: used to destroy an `Entity` touching
+	/// only the storages that hold it.
+	EntitySignatures entity_signatures;
+	/// The storages that don't notify the `entity_signatures`: these are always
+	/// checked when an `Entity` is destroyed.
+	LocalVector<godex::component_id> untracked_storages;
+	/// Used by `flush` to remove the components in batch, per storage.
+	LocalVector<LocalVector<EntityID>> removal_lists;
+	LocalVector<EntityID> destroyed_entities;
+
+	/// The amount of components `flush` can move, each time, to sort the
+	/// storages by `EntityID`. `0` disables the sorting.
+	uint32_t sort_budget = 0;
+	/// The storage from which the next `flush` starts sorting, so all the
+	/// storages get their turn.
+	godex::component_id sort_cursor = 0;
+
 	/// Storages configuration, the format is as follows:
 	/// {"Component Name" :{"param_1": 11, "param_2": 11},
 	///  "Component Name" :{"param_1": 11, "param_2": 11},
@@ -97,7 +204,22 @@ class World : public godex::Databag {
 
 	static void _bind_methods();
 
+	/// Destroys the `Entities` marked for disposal.
+	void destroy_garbage();
+	/// Drops the structural log entries, read by the `QueryCache`s, once
+	/// rebuilding them is cheaper than reading the log.
+	void trim_structural_logs();
+	/// Sorts the storages by `EntityID`, within the `sort_budget`.
+	void sort_storages();
+	/// Forgets the changes older than `CHANGE_TICK_MAX_AGE`, once every
+	/// `CHANGE_TICK_REBASE_PERIOD` ticks, so the ticks never wrap around.
+	void rebase_change_ticks();
+
 public:
+	/// The changes older than this amount of ticks are forgotten.
+	static constexpr uint32_t CHANGE_TICK_MAX_AGE = 1 << 30;
+	static constexpr uint32_t CHANGE_TICK_REBASE_PERIOD = 1 << 24;
+
 	World();
 	~World();
 
@@ -126,15 +248,48 @@ public:
 	/// It's undefined behavior use it in any other way than the above one.
 	const EntityBuilder &create_entity();
 
+	/// Creates `p_count` `Entities` at once, each one with a copy of the given
+	/// components. It's a lot faster than creating the `Entities` one by one:
+	/// the storages reserve the memory once and store the components
+	/// contiguously.
+	/// ```
+	///	EntityRange bullets = world.spawn_batch(50000, TransformComponent(), Velocity());
+	///	for (uint32_t i = 0; i < bullets.count; i += 1) {
+	///		EntityID bullet = bullets[i];
+	///	}
+	/// ```
+	///
+	/// The IDs are contiguous, so the destroyed IDs are never recycled: each
+	/// batch takes never used indices, that are limited to
+	/// `EntityID::MAX_INDEX`. Use `create_entity` or `CommandBuffer::spawn`
+	/// for the `Entities` spawned and destroyed continuously.
+	template <class... Cs>
+	EntityRange spawn_batch(uint32_t p_count, const Cs &...p_components);
+
 	/// Remove the entity from this World.
 	void destroy_entity(EntityID p_entity);
 
+	/// Returns `true` if this `Entity` exists: `false` when it was never
+	/// created or it's already destroyed.
+	bool is_entity_alive(EntityID p_entity) const;
+
 	WorldCommands &get_commands();
 	const WorldCommands &get_commands() const;
 
-	/// Flushes every pending action.
+	/// Flushes every pending action, and sorts some storages by `EntityID`
+	/// (see `set_sort_budget`).
 	void flush();
 
+	/// Sets the amount of components each `flush` can move to sort the
+	/// storages by `EntityID`: the sort is incremental, so when the budget is
+	/// over it continues on the next `flush`. `0` (default) disables it.
+	void set_sort_budget(uint32_t p_budget);
+	uint32_t get_sort_budget() const;
+
+	/// Applies the commands recorded into this `CommandBuffer` and clears it:
+	/// each storage receives all its components at once.
+	void apply_commands(CommandBuffer &p_commands);
+
 	/// Adds a new component (or sets the default if already exists) to a
 	/// specific Entity.
 	template <class C>
@@ -158,6 +313,18 @@ public:
 	godex::SID create_shared_component(uint32_t p_component_id, const Dictionary &p_component_data);
 	void add_shared_component(EntityID p_entity, uint32_t p_component_id, godex::SID p_shared_component_id);
 
+	/// Returns the id of the `Pipeline` stage in execution, `0` outside a
+	/// stage. The structural changes are deferred to the end of the stage, so
+	/// the structure is stable while the id doesn't change.
+	uint64_t get_dispatch_stage() const;
+
+	/// Returns the oldest tick that can still be compared: the older changes
+	/// are forgotten.
+	uint32_t get_oldest_change_tick() const;
+
+	/// Returns the cache of the `CachedQuery` with this id, creating it.
+	QueryCache *get_query_cache(uint32_t p_cache_id);
+
 	/// Returns the const storage pointed by the give ID.
 	const StorageBase *get_storage(uint32_t p_storage_id) const;
 
@@ -222,12 +389,21 @@ public:
 	const godex::Databag *get_databag(godex::databag_id p_id) const;
 
 private:
+	/// Adds the component to all the `Entities` of the range.
+	template <class C>
+	void insert_batch(const EntityRange &p_range, const C &p_data);
+
 	/// Creates a new component storage into the world, if the storage
 	/// already exists, does nothing.
 	template <class C>
 	void create_storage();
 	void create_storage(uint32_t p_component_id);
 
+	/// Same as `create_storage`, but it creates the storage even during the
+	/// dispatching: only call it when no `System` is running, like at the
+	/// end of a stage.
+	void create_storage_at_sync_point(uint32_t p_component_id);
+
 	/// Destroy a component storage if exists.
 	// TODO when this is called?
 	template <class C>
@@ -249,6 +425,21 @@ void World::add_component(EntityID p_entity, const C &p_data) {
 	storage->insert(p_entity, p_data);
 }
 
+template <class... Cs>
+EntityRange World::spawn_batch(uint32_t p_count, const Cs &...p_components) {
+	const EntityRange range = commands.create_entities(p_count);
+	(insert_batch(range, p_components), ...);
+	return range;
+}
+
+template <class C>
+void World::insert_batch(const EntityRange &p_range, const C &p_data) {
+	create_storage<C>();
+	Storage<C> *storage = get_storage<C>();
+	ERR_FAIL_COND(storage == nullptr);
+	storage->insert_batch(p_range.first, p_range.count, p_data);
+}
+
 template <class C>
 void World::remove_component(EntityID p_entity) {
 	remove_component(p_entity, C::get_component_id());